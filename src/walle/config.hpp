@@ -12,35 +12,47 @@
 #ifndef CONFIG_HPP
 #define CONFIG_HPP
 
+#include <stdint.h>
+
+
+/*---- PWM Boards -----------------------------------------------------
+*  I2C address of each PCA9685 board, set by the solder jumpers on the
+*  board (A0-A5 add 1, 2, 4, ... to 0x40). Boards are numbered by their
+*  position in this list. Add an entry to chain another board.
+*  -------------------------------------------------------------------*/
+const uint8_t PCA9685_I2C_ADDRESSES[] = {
+    0x40, // Board 0
+};
 
 /*---- Motor Index Mapping --------------------------------------------
 *  The following constants are used to map the servo motors to the
-*  corresponding index of the PWM module. The index is printed on the
-*  silkscreen of the module.
+*  corresponding board and index of the PWM modules, written as
+*  { board, index }. The board is its position in PCA9685_I2C_ADDRESSES
+*  and the index is printed on the silkscreen of the module.
 *  -------------------------------------------------------------------*/
 // Drive motors
-#define MOTOR_RIGHT_IDX (0)
-#define MOTOR_LEFT_IDX  (1)
+#define MOTOR_RIGHT_ADDR { 0, 0 }
+#define MOTOR_LEFT_ADDR  { 0, 1 }
 
 // Arm servos
-#define SERVO_SHOULDER_RIGHT_IDX (2)
-#define SERVO_SHOULDER_LEFT_IDX  (3)
+#define SERVO_SHOULDER_RIGHT_ADDR { 0, 2 }
+#define SERVO_SHOULDER_LEFT_ADDR  { 0, 3 }
 
-#define SERVO_ELBOW_RIGHT_IDX (4)
-#define SERVO_ELBOW_LEFT_IDX  (5)
+#define SERVO_ELBOW_RIGHT_ADDR { 0, 4 }
+#define SERVO_ELBOW_LEFT_ADDR  { 0, 5 }
 
-#define SERVO_WRIST_RIGHT_IDX (6)
-#define SERVO_WRIST_LEFT_IDX  (7)
+#define SERVO_WRIST_RIGHT_ADDR { 0, 6 }
+#define SERVO_WRIST_LEFT_ADDR  { 0, 7 }
 
-#define SERVO_HAND_RIGHT_IDX  (8)
-#define SERVO_HAND_LEFT_IDX   (9)
+#define SERVO_HAND_RIGHT_ADDR  { 0, 8 }
+#define SERVO_HAND_LEFT_ADDR   { 0, 9 }
 
 // Head servos
-#define SERVO_NECK_PITCH_IDX  (14)
-#define SERVO_NECK_YAW_IDX    (15)
+#define SERVO_NECK_PITCH_ADDR  { 0, 14 }
+#define SERVO_NECK_YAW_ADDR    { 0, 15 }
                         
-#define SERVO_EYE_RIGHT_IDX   (12)
-#define SERVO_EYE_LEFT_IDX    (13)
+#define SERVO_EYE_RIGHT_ADDR   { 0, 12 }
+#define SERVO_EYE_LEFT_ADDR    { 0, 13 }
 
 /*---- Track Motor Configs --------------------------------------------
 *  The following constants setup parameters for the track motors.
@@ -96,6 +108,9 @@ const TrackVelocityProfile_t TRACK_VELOCITY_PROFILES[] = {
 #define SERVO_EYE_LEFT_MIN_US (1000)
 #define SERVO_EYE_LEFT_NEUTRAL_US (1500)
 
+// Easing curve of every servo's ramps. Keyframes use their own curve for the ramps they start.
+#define SERVO_RAMP_MODE (SINUSOIDAL_INOUT)
+
 // Uncomment a line to reverse the direction of the track motor
 // #define MOTOR_RIGHT_REVERSE_DIRECTION
 // #define MOTOR_LEFT_REVERSE_DIRECTION
@@ -175,6 +190,34 @@ const int audio_track_selection_list[] = {
 // registers input. Used to combat controller drift. Value is out of 512.
 #define CONTROLLER_DEADZONE (25)
 
+/*---- Motion Task Settings --------------------------------------------
+*  Servo and track outputs are updated from their own FreeRTOS task,
+*  so display redraws and audio/controller polling in loop() can't
+*  delay them. The ramps and animations run several times per servo
+*  PWM period, but each channel is only written to the PCA9685 once
+*  per period, with its newest value.
+*  -------------------------------------------------------------------*/
+// loop() runs on core 1 and Bluetooth on core 0. Keeping the motion task on core 1 with a higher priority lets it
+// preempt loop() (priority 1) without competing with the Bluetooth stack.
+#define MOTION_TASK_CORE        (1)
+#define MOTION_TASK_PRIORITY    (5)
+#define MOTION_TASK_STACK_BYTES (4096)
+
+// Number of control ticks per servo PWM period. Should divide the period into whole milliseconds (FreeRTOS ticks).
+#define MOTION_TICKS_PER_PWM_PERIOD (4)
+
+// Comment out to write the outputs at a fixed point in each period instead of just before the PCA9685 starts its next
+// period. Alignment relies on PCA9685_OSCILLATION_FREQ being close to the board's real oscillator frequency.
+#define MOTION_ALIGN_OUTPUT_TO_PWM_PERIOD
+// How long before the estimated period start the write must be finished. Covers the I2C transaction and any error in
+// the period start estimate.
+#define MOTION_OUTPUT_MARGIN_US (1500)
+
+// When an animation starts while another one plays, the servos are blended from the old one into the new one over this
+// window. They carry on at the speed they had and ease into the new animation instead of turning on the spot, which
+// draws a current spike. 0 switches straight away.
+#define ANIMATION_CROSSFADE_MS (150)
+
 /*---- General Settings -----------------------------------------------
 *  Various settings for the platform.
 *  -------------------------------------------------------------------*/
@@ -182,4 +225,7 @@ const int audio_track_selection_list[] = {
 // for development but should generally be false for animations to persist across boots. 
 // #define FORMAT_SPIFFS_ON_STARTUP // Uncomment to format the SPIFFS file system on startup
 
+// Prints how many CPU cycles each easing curve takes with and without its lookup table, before the motion task starts
+// #define EASING_BENCHMARK_ON_STARTUP // Uncomment to run the easing benchmark on startup
+
 #endif /* CONFIG_HPP */
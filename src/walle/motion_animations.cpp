@@ -23,58 +23,58 @@ ServoAnimation wiggle_eyes   = ServoAnimation();
 // Create setup functions for each animation.
 // NOTE: Don't forget to call these functions in setup_animations().
 
-void setup_cock_left(ServoContext servos) {
+void setup_cock_left(ServoContext &servos) {
     // cock_left cocks WALL-E's head to the left by settings the left eye to the minimum angle and the right eye to the
     // max angle
     ServoKeyframe *cock_left_keyframe_1 = new ServoKeyframe(1000);
-    cock_left_keyframe_1->add_servo_scalar(servos.map[SERVO_EYE_LEFT_NAME], 1.0);
-    cock_left_keyframe_1->add_servo_scalar(servos.map[SERVO_EYE_RIGHT_NAME], 0.75);
+    cock_left_keyframe_1->add_servo_scalar(servos.get(SERVO_ID_EYE_LEFT), 1.0);
+    cock_left_keyframe_1->add_servo_scalar(servos.get(SERVO_ID_EYE_RIGHT), 0.75);
     // Pause keyframe
     ServoKeyframe *cock_left_keyframe_2 = new ServoKeyframe(4000);
     // Return to neutral
     ServoKeyframe *cock_left_keyframe_3 = new ServoKeyframe(1000);
-    cock_left_keyframe_3->add_servo_scalar(servos.map[SERVO_EYE_LEFT_NAME], 0.0);
-    cock_left_keyframe_3->add_servo_scalar(servos.map[SERVO_EYE_RIGHT_NAME], 0.0);
+    cock_left_keyframe_3->add_servo_scalar(servos.get(SERVO_ID_EYE_LEFT), 0.0);
+    cock_left_keyframe_3->add_servo_scalar(servos.get(SERVO_ID_EYE_RIGHT), 0.0);
 
     cock_left.add_keyframe(cock_left_keyframe_1);
     cock_left.add_keyframe(cock_left_keyframe_2);
     cock_left.add_keyframe(cock_left_keyframe_3);
 }
 
-void setup_cock_right(ServoContext servos) {
+void setup_cock_right(ServoContext &servos) {
     // cock_right cocks WALL-E's head to the left by settings the left eye to the minimum angle and the right eye to the
     // max angle
     ServoKeyframe *cock_right_keyframe_1 = new ServoKeyframe(1000);
-    cock_right_keyframe_1->add_servo_scalar(servos.map[SERVO_EYE_LEFT_NAME], 1.0);
-    cock_right_keyframe_1->add_servo_scalar(servos.map[SERVO_EYE_RIGHT_NAME], 0.75);
+    cock_right_keyframe_1->add_servo_scalar(servos.get(SERVO_ID_EYE_LEFT), 1.0);
+    cock_right_keyframe_1->add_servo_scalar(servos.get(SERVO_ID_EYE_RIGHT), 0.75);
     // Pause keyframe
     ServoKeyframe *cock_right_keyframe_2 = new ServoKeyframe(4000);
     // Return to neutral
     ServoKeyframe *cock_right_keyframe_3 = new ServoKeyframe(1000);
-    cock_right_keyframe_3->add_servo_scalar(servos.map[SERVO_EYE_LEFT_NAME], 0.0);
-    cock_right_keyframe_3->add_servo_scalar(servos.map[SERVO_EYE_RIGHT_NAME], 0.0);
+    cock_right_keyframe_3->add_servo_scalar(servos.get(SERVO_ID_EYE_LEFT), 0.0);
+    cock_right_keyframe_3->add_servo_scalar(servos.get(SERVO_ID_EYE_RIGHT), 0.0);
 
     cock_right.add_keyframe(cock_right_keyframe_1);
     cock_right.add_keyframe(cock_right_keyframe_2);
     cock_right.add_keyframe(cock_right_keyframe_3);
 }
 
-void setup_sad(ServoContext servos) {
+void setup_sad(ServoContext &servos) {
     // Make WALL-E look sad by putting both eyes down, then tilting the head down
     // Eyes droop
     ServoKeyframe *sad_keyframe1 = new ServoKeyframe(2000);
-    sad_keyframe1->add_servo_scalar(servos.map[SERVO_EYE_LEFT_NAME], -1.0);
-    sad_keyframe1->add_servo_scalar(servos.map[SERVO_EYE_RIGHT_NAME], 1.0);
+    sad_keyframe1->add_servo_scalar(servos.get(SERVO_ID_EYE_LEFT), -1.0);
+    sad_keyframe1->add_servo_scalar(servos.get(SERVO_ID_EYE_RIGHT), 1.0);
     // Tilt head down
     ServoKeyframe *sad_keyframe2 = new ServoKeyframe(2000);
-    sad_keyframe2->add_servo_scalar(servos.map[SERVO_NECK_PITCH_NAME], -0.8);
+    sad_keyframe2->add_servo_scalar(servos.get(SERVO_ID_NECK_PITCH), -0.8);
     // Pause
     ServoKeyframe *sad_keyframe3 = new ServoKeyframe(4000);
     // Reset
     ServoKeyframe *sad_keyframe4 = new ServoKeyframe(2000);
-    sad_keyframe4->add_servo_scalar(servos.map[SERVO_EYE_LEFT_NAME], 0.0);
-    sad_keyframe4->add_servo_scalar(servos.map[SERVO_EYE_RIGHT_NAME], 0.0);
-    sad_keyframe4->add_servo_scalar(servos.map[SERVO_NECK_PITCH_NAME], 0.0);
+    sad_keyframe4->add_servo_scalar(servos.get(SERVO_ID_EYE_LEFT), 0.0);
+    sad_keyframe4->add_servo_scalar(servos.get(SERVO_ID_EYE_RIGHT), 0.0);
+    sad_keyframe4->add_servo_scalar(servos.get(SERVO_ID_NECK_PITCH), 0.0);
 
     // Add keyframes to animation
     sad.add_keyframe(sad_keyframe1);
@@ -83,29 +83,29 @@ void setup_sad(ServoContext servos) {
     sad.add_keyframe(sad_keyframe4);
 }
 
-void setup_curious_track(ServoContext servos) {
+void setup_curious_track(ServoContext &servos) {
     // Make WALL-E look like he's tracking something on the ground
     ServoKeyframe *curious_track_keyframe1 = new ServoKeyframe(2000);
     // Looks down and to the left a little
-    curious_track_keyframe1->add_servo_scalar(servos.map[SERVO_NECK_PITCH_NAME], -0.6);
-    curious_track_keyframe1->add_servo_scalar(servos.map[SERVO_NECK_YAW_NAME], -0.5);
+    curious_track_keyframe1->add_servo_scalar(servos.get(SERVO_ID_NECK_PITCH), -0.6);
+    curious_track_keyframe1->add_servo_scalar(servos.get(SERVO_ID_NECK_YAW), -0.5);
     // Cock eyes
     ServoKeyframe *curious_track_keyframe2 = new ServoKeyframe(1000);
-    curious_track_keyframe2->add_servo_scalar(servos.map[SERVO_EYE_LEFT_NAME], 0.7);
-    curious_track_keyframe2->add_servo_scalar(servos.map[SERVO_EYE_RIGHT_NAME], 0.5);
+    curious_track_keyframe2->add_servo_scalar(servos.get(SERVO_ID_EYE_LEFT), 0.7);
+    curious_track_keyframe2->add_servo_scalar(servos.get(SERVO_ID_EYE_RIGHT), 0.5);
     // Track the object from left to right
     ServoKeyframe *curious_track_keyframe3 = new ServoKeyframe(6000);
-    curious_track_keyframe3->add_servo_scalar(servos.map[SERVO_NECK_YAW_NAME], 0.5);
-    curious_track_keyframe3->add_servo_scalar(servos.map[SERVO_EYE_LEFT_NAME], 0.0);
-    curious_track_keyframe3->add_servo_scalar(servos.map[SERVO_EYE_RIGHT_NAME], 0.0);
+    curious_track_keyframe3->add_servo_scalar(servos.get(SERVO_ID_NECK_YAW), 0.5);
+    curious_track_keyframe3->add_servo_scalar(servos.get(SERVO_ID_EYE_LEFT), 0.0);
+    curious_track_keyframe3->add_servo_scalar(servos.get(SERVO_ID_EYE_RIGHT), 0.0);
     // Pause
     ServoKeyframe *curious_track_keyframe4 = new ServoKeyframe(1000);
     // Reset
     ServoKeyframe *curious_track_keyframe5 = new ServoKeyframe(1000);
-    curious_track_keyframe5->add_servo_scalar(servos.map[SERVO_NECK_PITCH_NAME], 0.0);
-    curious_track_keyframe5->add_servo_scalar(servos.map[SERVO_NECK_YAW_NAME], 0.0);
-    curious_track_keyframe5->add_servo_scalar(servos.map[SERVO_EYE_LEFT_NAME], 0.0);
-    curious_track_keyframe5->add_servo_scalar(servos.map[SERVO_EYE_RIGHT_NAME], 0.0);
+    curious_track_keyframe5->add_servo_scalar(servos.get(SERVO_ID_NECK_PITCH), 0.0);
+    curious_track_keyframe5->add_servo_scalar(servos.get(SERVO_ID_NECK_YAW), 0.0);
+    curious_track_keyframe5->add_servo_scalar(servos.get(SERVO_ID_EYE_LEFT), 0.0);
+    curious_track_keyframe5->add_servo_scalar(servos.get(SERVO_ID_EYE_RIGHT), 0.0);
 
     // Add keyframes to animation
     curious_track.add_keyframe(curious_track_keyframe1);
@@ -115,27 +115,27 @@ void setup_curious_track(ServoContext servos) {
     curious_track.add_keyframe(curious_track_keyframe5);
 }
 
-void setup_wiggle_eyes(ServoContext servos) {
+void setup_wiggle_eyes(ServoContext &servos) {
     // Make WALL-E wiggle his eyes in excitingment
     ServoKeyframe *wiggle_eyes_keyframe1 = new ServoKeyframe(500);
-    wiggle_eyes_keyframe1->add_servo_scalar(servos.map[SERVO_EYE_LEFT_NAME], 0.5);
-    wiggle_eyes_keyframe1->add_servo_scalar(servos.map[SERVO_EYE_RIGHT_NAME], -0.5);
+    wiggle_eyes_keyframe1->add_servo_scalar(servos.get(SERVO_ID_EYE_LEFT), 0.5);
+    wiggle_eyes_keyframe1->add_servo_scalar(servos.get(SERVO_ID_EYE_RIGHT), -0.5);
     // Wiggle other direction
     ServoKeyframe *wiggle_eyes_keyframe2 = new ServoKeyframe(500);
-    wiggle_eyes_keyframe2->add_servo_scalar(servos.map[SERVO_EYE_LEFT_NAME], -0.5);
-    wiggle_eyes_keyframe2->add_servo_scalar(servos.map[SERVO_EYE_RIGHT_NAME], 0.5);
+    wiggle_eyes_keyframe2->add_servo_scalar(servos.get(SERVO_ID_EYE_LEFT), -0.5);
+    wiggle_eyes_keyframe2->add_servo_scalar(servos.get(SERVO_ID_EYE_RIGHT), 0.5);
     // Repeat
     ServoKeyframe *wiggle_eyes_keyframe3 = new ServoKeyframe(500);
-    wiggle_eyes_keyframe3->add_servo_scalar(servos.map[SERVO_EYE_LEFT_NAME], 0.5);
-    wiggle_eyes_keyframe3->add_servo_scalar(servos.map[SERVO_EYE_RIGHT_NAME], -0.5);
+    wiggle_eyes_keyframe3->add_servo_scalar(servos.get(SERVO_ID_EYE_LEFT), 0.5);
+    wiggle_eyes_keyframe3->add_servo_scalar(servos.get(SERVO_ID_EYE_RIGHT), -0.5);
     // Wiggle other direction
     ServoKeyframe *wiggle_eyes_keyframe4 = new ServoKeyframe(500);
-    wiggle_eyes_keyframe4->add_servo_scalar(servos.map[SERVO_EYE_LEFT_NAME], -0.5);
-    wiggle_eyes_keyframe4->add_servo_scalar(servos.map[SERVO_EYE_RIGHT_NAME], 0.5);
+    wiggle_eyes_keyframe4->add_servo_scalar(servos.get(SERVO_ID_EYE_LEFT), -0.5);
+    wiggle_eyes_keyframe4->add_servo_scalar(servos.get(SERVO_ID_EYE_RIGHT), 0.5);
     // Reset
     ServoKeyframe *wiggle_eyes_keyframe5 = new ServoKeyframe(250);
-    wiggle_eyes_keyframe5->add_servo_scalar(servos.map[SERVO_EYE_LEFT_NAME], 0.0);
-    wiggle_eyes_keyframe5->add_servo_scalar(servos.map[SERVO_EYE_RIGHT_NAME], 0.0);
+    wiggle_eyes_keyframe5->add_servo_scalar(servos.get(SERVO_ID_EYE_LEFT), 0.0);
+    wiggle_eyes_keyframe5->add_servo_scalar(servos.get(SERVO_ID_EYE_RIGHT), 0.0);
 
     // Add keyframes to animation
     wiggle_eyes.add_keyframe(wiggle_eyes_keyframe1);
@@ -145,7 +145,14 @@ void setup_wiggle_eyes(ServoContext servos) {
     wiggle_eyes.add_keyframe(wiggle_eyes_keyframe5);
 }
 
-void setup_animations(ServoContext servos) {
+void bake_animation(ServoAnimation &animation, const char *name, unsigned long baked_frame_us) {
+    // An animation that can't be baked still plays, from its keyframes
+    if (!animation.bake(baked_frame_us)) {
+        Serial.printf("Failed to bake %s, playing it from its keyframes\n", name);
+    }
+}
+
+void setup_animations(ServoContext &servos, unsigned long baked_frame_us) {
     // This function should get called in the main setup() function. It calls all animation setup functions for use in
     // the main sketch.
 
@@ -156,5 +163,11 @@ void setup_animations(ServoContext servos) {
     setup_sad(servos);
     setup_curious_track(servos);
     setup_wiggle_eyes(servos);
+
+    // Short animations that play often are baked, so they cost the same per tick however many keyframes they have.
+    // Each takes 2 bytes per servo per frame, so keep long animations on their keyframes.
+    bake_animation(cock_left, "cock_left", baked_frame_us);
+    bake_animation(cock_right, "cock_right", baked_frame_us);
+    bake_animation(wiggle_eyes, "wiggle_eyes", baked_frame_us);
 }
 } // namespace MotionAnimations
\ No newline at end of file
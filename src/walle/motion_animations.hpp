@@ -25,7 +25,7 @@ namespace MotionAnimations {
     extern ServoAnimation curious_track;
     extern ServoAnimation wiggle_eyes;
     
-    void setup_animations(ServoContext servos);
+    void setup_animations(ServoContext &servos, unsigned long baked_frame_us);
 }
 
 #endif // MOTION_ANIMATIONS_HPP
@@ -0,0 +1,70 @@
+/**
+ * @file servo_joints.hpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the SERVO_JOINTS table, which describes every servo joint of WALL-E from the settings in
+ * config.hpp. The table is built and checked at compile time.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef SERVO_JOINTS_HPP
+#define SERVO_JOINTS_HPP
+
+#include "config.hpp"
+#include "src/motion/servo_context.hpp"
+#include "src/motion/servo_joint.hpp"
+#include "src/motion/pwm_frame.hpp"
+
+// One entry per ServoId, in ServoId order. Limits and rates are set in config.hpp.
+constexpr ServoJoint SERVO_JOINTS[] = {
+    ServoJoint(SERVO_ID_NECK_YAW, SERVO_NECK_YAW_NAME, SERVO_NECK_YAW_ADDR, SERVO_NECK_YAW_MIN_US,
+               SERVO_NECK_YAW_NEUTRAL_US, SERVO_NECK_YAW_MAX_US, SERVO_RAMP_MODE, HEAD_YAW_RATE_PER_S),
+    ServoJoint(SERVO_ID_NECK_PITCH, SERVO_NECK_PITCH_NAME, SERVO_NECK_PITCH_ADDR, SERVO_NECK_PITCH_MIN_US,
+               SERVO_NECK_PITCH_NEUTRAL_US, SERVO_NECK_PITCH_MAX_US, SERVO_RAMP_MODE, HEAD_PITCH_RATE_PER_S),
+
+    ServoJoint(SERVO_ID_EYE_LEFT, SERVO_EYE_LEFT_NAME, SERVO_EYE_LEFT_ADDR, SERVO_EYE_LEFT_MIN_US,
+               SERVO_EYE_LEFT_NEUTRAL_US, SERVO_EYE_LEFT_MAX_US, SERVO_RAMP_MODE, EYE_MOVE_RATE_PER_S),
+    ServoJoint(SERVO_ID_EYE_RIGHT, SERVO_EYE_RIGHT_NAME, SERVO_EYE_RIGHT_ADDR, SERVO_EYE_RIGHT_MIN_US,
+               SERVO_EYE_RIGHT_NEUTRAL_US, SERVO_EYE_RIGHT_MAX_US, SERVO_RAMP_MODE, EYE_MOVE_RATE_PER_S),
+
+    ServoJoint(SERVO_ID_SHOULDER_LEFT, SERVO_SHOULDER_LEFT_NAME, SERVO_SHOULDER_LEFT_ADDR, SERVO_SHOULDER_MIN_US,
+               SERVO_SHOULDER_NEUTRAL_US, SERVO_SHOULDER_MAX_US, SERVO_RAMP_MODE, SHOULDER_MOVE_RATE_PER_S),
+    ServoJoint(SERVO_ID_SHOULDER_RIGHT, SERVO_SHOULDER_RIGHT_NAME, SERVO_SHOULDER_RIGHT_ADDR, SERVO_SHOULDER_MIN_US,
+               SERVO_SHOULDER_NEUTRAL_US, SERVO_SHOULDER_MAX_US, SERVO_RAMP_MODE, SHOULDER_MOVE_RATE_PER_S),
+
+    ServoJoint(SERVO_ID_ELBOW_LEFT, SERVO_ELBOW_LEFT_NAME, SERVO_ELBOW_LEFT_ADDR, SERVO_ELBOW_MIN_US,
+               SERVO_ELBOW_NEUTRAL_US, SERVO_ELBOW_MAX_US, SERVO_RAMP_MODE, ELBOW_MOVE_RATE_PER_S),
+    ServoJoint(SERVO_ID_ELBOW_RIGHT, SERVO_ELBOW_RIGHT_NAME, SERVO_ELBOW_RIGHT_ADDR, SERVO_ELBOW_MIN_US,
+               SERVO_ELBOW_NEUTRAL_US, SERVO_ELBOW_MAX_US, SERVO_RAMP_MODE, ELBOW_MOVE_RATE_PER_S),
+
+    ServoJoint(SERVO_ID_WRIST_LEFT, SERVO_WRIST_LEFT_NAME, SERVO_WRIST_LEFT_ADDR, SERVO_WRIST_MIN_US,
+               SERVO_WRIST_NEUTRAL_US, SERVO_WRIST_MAX_US, SERVO_RAMP_MODE, WRIST_MOVE_RATE_PER_S),
+    ServoJoint(SERVO_ID_WRIST_RIGHT, SERVO_WRIST_RIGHT_NAME, SERVO_WRIST_RIGHT_ADDR, SERVO_WRIST_MIN_US,
+               SERVO_WRIST_NEUTRAL_US, SERVO_WRIST_MAX_US, SERVO_RAMP_MODE, WRIST_MOVE_RATE_PER_S),
+
+    ServoJoint(SERVO_ID_HAND_LEFT, SERVO_HAND_LEFT_NAME, SERVO_HAND_LEFT_ADDR, SERVO_HAND_MIN_US,
+               SERVO_HAND_NEUTRAL_US, SERVO_HAND_MAX_US, SERVO_RAMP_MODE, HAND_MOVE_RATE_PER_S),
+    ServoJoint(SERVO_ID_HAND_RIGHT, SERVO_HAND_RIGHT_NAME, SERVO_HAND_RIGHT_ADDR, SERVO_HAND_MIN_US,
+               SERVO_HAND_NEUTRAL_US, SERVO_HAND_MAX_US, SERVO_RAMP_MODE, HAND_MOVE_RATE_PER_S),
+};
+const int NUM_SERVO_JOINTS = sizeof(SERVO_JOINTS) / sizeof(SERVO_JOINTS[0]);
+
+static_assert(NUM_SERVO_JOINTS == SERVO_ID_COUNT, "SERVO_JOINTS needs exactly one entry per ServoId");
+static_assert(servo_joints_are_indexed(SERVO_JOINTS, NUM_SERVO_JOINTS),
+              "SERVO_JOINTS entries must be in ServoId order");
+static_assert(servo_joints_are_ordered(SERVO_JOINTS, NUM_SERVO_JOINTS),
+              "A servo's min/neutral/max pulse widths or angles in config.hpp are out of order");
+static_assert(servo_joints_have_unique_addresses(SERVO_JOINTS, NUM_SERVO_JOINTS),
+              "Two servos in config.hpp share a board and channel");
+static_assert(servo_joints_fit(SERVO_JOINTS, NUM_SERVO_JOINTS,
+                               sizeof(PCA9685_I2C_ADDRESSES) / sizeof(PCA9685_I2C_ADDRESSES[0]),
+                               PwmFrame::NUM_CHANNELS),
+              "A servo in config.hpp is on a board missing from PCA9685_I2C_ADDRESSES or on a channel past 15");
+static_assert(servo_joints_leave_unused(PwmAddress MOTOR_RIGHT_ADDR, SERVO_JOINTS, NUM_SERVO_JOINTS),
+              "A servo in config.hpp shares MOTOR_RIGHT_ADDR with the right drive motor");
+static_assert(servo_joints_leave_unused(PwmAddress MOTOR_LEFT_ADDR, SERVO_JOINTS, NUM_SERVO_JOINTS),
+              "A servo in config.hpp shares MOTOR_LEFT_ADDR with the left drive motor");
+
+#endif // SERVO_JOINTS_HPP
@@ -0,0 +1,31 @@
+/**
+ * @file track_request.cpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the implementation for the TrackRequest class. This class lets tasks other than loop() ask
+ * for a track to be played without touching the DfMp3 serial port themselves.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "track_request.hpp"
+
+std::atomic<DfMp3 *>  TrackRequest::_dfmp3(nullptr);
+std::atomic<uint16_t> TrackRequest::_track_index(0);
+
+void TrackRequest::post(DfMp3 *dfmp3, uint16_t track_index) {
+    if (dfmp3 == nullptr || track_index == 0) {
+        return;
+    }
+    // Publish the player before the track index, service() only looks at the player once it sees the index
+    _dfmp3.store(dfmp3, std::memory_order_relaxed);
+    _track_index.store(track_index, std::memory_order_release);
+}
+
+void TrackRequest::service() {
+    uint16_t track_index = _track_index.exchange(0, std::memory_order_acquire);
+    if (track_index != 0) {
+        _dfmp3.load(std::memory_order_relaxed)->playMp3FolderTrack(track_index);
+    }
+}
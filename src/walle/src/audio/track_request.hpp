@@ -0,0 +1,46 @@
+/**
+ * @file track_request.hpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the declaration for the TrackRequest class. This class lets tasks other than loop() ask for
+ * a track to be played without touching the DfMp3 serial port themselves.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef TRACK_REQUEST_HPP
+#define TRACK_REQUEST_HPP
+
+#include <Arduino.h>
+#include <atomic>
+#include "audio_player.hpp"
+
+/**
+ * @brief A single slot mailbox for track play requests.
+ *
+ * The DfMp3 object is not thread safe and is serviced from loop(), so the motion task posts the tracks its keyframes
+ * want to play here and loop() plays them on its next pass. Only the most recent request is kept; a track posted before
+ * the previous one was serviced replaces it.
+ */
+class TrackRequest {
+  public:
+    /**
+     * @brief Requests that a track is played. Safe to call from any task.
+     *
+     * @param dfmp3 The DfMp3 object to play the track with.
+     * @param track_index The index of the track to play. 0 is ignored.
+     */
+    static void post(DfMp3 *dfmp3, uint16_t track_index);
+
+    /**
+     * @brief Plays the pending track, if there is one. Must be called from the task that owns the DfMp3 object.
+     */
+    static void service();
+
+  private:
+    static std::atomic<DfMp3 *>  _dfmp3;       ///< The DfMp3 object of the pending request.
+    static std::atomic<uint16_t> _track_index; ///< The pending track index, 0 if there is none.
+};
+
+#endif // TRACK_REQUEST_HPP
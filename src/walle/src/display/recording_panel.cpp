@@ -181,8 +181,9 @@ void RecordingPanel::_drawRecordingPageStatic(TFT_eSPI &tft) {
     /*----------- Servos --------------------------------*/
     _servo_info_start_y = tft.getCursorY() + _LEADING_MEDIUM_PIXELS;
     tft.setCursor(tft.getCursorX(), _servo_info_start_y, _FONT_NUMBER);
-    for (auto servo_name : _SERVO_DISPLAY_ORDER) {
-        tft.print(servo_name);
+    for (auto servo_id : _SERVO_DISPLAY_ORDER) {
+        ServoMotor *servo = _servos->get(servo_id);
+        tft.print(servo != nullptr ? servo->get_name() : "");
         tft.println(": ");
         tft.setCursor(tft.getCursorX(), tft.getCursorY() + _LEADING_SMALL_PIXELS, _FONT_NUMBER);
     }
@@ -225,21 +226,24 @@ void RecordingPanel::_drawCancelPage(TFT_eSPI &tft) {
 }
 
 void RecordingPanel::_drawServoPositions(TFT_eSPI &tft, bool force_update) {
-    for (auto servo_name : _SERVO_DISPLAY_ORDER) {
-        _given_info.servo_positions[servo_name] = _servos->map[servo_name]->get_current_scalar();
-    }
-
     tft.setTextColor(_FONT_COLOR_B, _DISPLAY_BACKGROUND_COLOR, true);
     int text_y = _servo_info_start_y;
     int font_height = tft.fontHeight(_FONT_NUMBER);
-    for (auto servo_name : _SERVO_DISPLAY_ORDER) {
+    for (auto servo_id : _SERVO_DISPLAY_ORDER) {
+        ServoMotor *servo = _servos->get(servo_id);
+        if (servo == nullptr) {
+            text_y += font_height + _LEADING_SMALL_PIXELS;
+            continue;
+        }
+        _given_info.servo_positions[servo_id] = servo->get_current_scalar();
+
         // Set the curosor to the end of the servo name label
-        tft.setCursor(_MARGIN + tft.textWidth(servo_name) + tft.textWidth(": "), text_y, _FONT_NUMBER);
+        tft.setCursor(_MARGIN + tft.textWidth(servo->get_name()) + tft.textWidth(": "), text_y, _FONT_NUMBER);
 
         // Print the servo position if it has changed or if we are forcing an update
-        if (_given_info.servo_positions[servo_name] != _last_update_info.servo_positions[servo_name] || force_update) {
-            tft.printf(_SERVO_POS_VALUE_FORMATTER, _given_info.servo_positions[servo_name]);
-            _last_update_info.servo_positions[servo_name] = _given_info.servo_positions[servo_name];
+        if (_given_info.servo_positions[servo_id] != _last_update_info.servo_positions[servo_id] || force_update) {
+            tft.printf(_SERVO_POS_VALUE_FORMATTER, _given_info.servo_positions[servo_id]);
+            _last_update_info.servo_positions[servo_id] = _given_info.servo_positions[servo_id];
         }
         text_y += font_height + _LEADING_SMALL_PIXELS;
     }
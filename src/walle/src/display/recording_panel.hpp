@@ -13,7 +13,6 @@
 #define RECORDING_PANEL_HPP
 
 #include <TFT_eSPI.h>
-#include <map>
 #include "display_common.hpp"
 #include "../motion/servo_context.hpp"
 
@@ -91,7 +90,7 @@ private:
         int keyframe_duration_ms;    /**< The duration of each keyframe in milliseconds. */
         int keyframe_num;    /**< The current keyframe number. */
         int duration_cursor_position;    /**< The current cursor position. */
-        std::map<std::string, float> servo_positions;    /**< The positions of the servos. */
+        float servo_positions[ServoContext::MAX_SERVOS];    /**< The positions of the servos, indexed by ID. */
     };
 
     const int _MARGIN = 0;
@@ -130,20 +129,20 @@ private:
     const char* _RECORDING_INFO_KEYFRAME_TEXT = "Keyframe: ";
     const char* _RECORDING_INFO_DURATION_TEXT = "Duration (sec): ";
 
-    // Define the order of the servos to be displayed
-    const char* _SERVO_DISPLAY_ORDER[12] = {
-        SERVO_EYE_LEFT_NAME,
-        SERVO_EYE_RIGHT_NAME,
-        SERVO_NECK_PITCH_NAME,
-        SERVO_NECK_YAW_NAME,
-        SERVO_SHOULDER_LEFT_NAME,
-        SERVO_SHOULDER_RIGHT_NAME,
-        SERVO_ELBOW_LEFT_NAME,
-        SERVO_ELBOW_RIGHT_NAME,
-        SERVO_WRIST_LEFT_NAME,
-        SERVO_WRIST_RIGHT_NAME,
-        SERVO_HAND_LEFT_NAME,
-        SERVO_HAND_RIGHT_NAME
+    // Define the order of the servos to be displayed, head first. It is a layout of its own, not ServoId order.
+    const int _SERVO_DISPLAY_ORDER[SERVO_ID_COUNT] = {
+        SERVO_ID_EYE_LEFT,
+        SERVO_ID_EYE_RIGHT,
+        SERVO_ID_NECK_PITCH,
+        SERVO_ID_NECK_YAW,
+        SERVO_ID_SHOULDER_LEFT,
+        SERVO_ID_SHOULDER_RIGHT,
+        SERVO_ID_ELBOW_LEFT,
+        SERVO_ID_ELBOW_RIGHT,
+        SERVO_ID_WRIST_LEFT,
+        SERVO_ID_WRIST_RIGHT,
+        SERVO_ID_HAND_LEFT,
+        SERVO_ID_HAND_RIGHT
     };
 
     Page _set_page;                        /**< The currently set page. */
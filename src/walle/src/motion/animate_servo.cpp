@@ -10,127 +10,726 @@
  *
  */
 #include "animate_servo.hpp"
+#include <climits>
+
+// The arena is freed without running the keyframes' destructors
+static_assert(std::is_trivially_destructible<ServoKeyframe>::value, "ServoKeyframe has to be trivially destructible");
+
+constexpr float ServoAnimation::MIN_RATE;
+constexpr float ServoAnimation::MAX_RATE;
 
 ServoAnimation::ServoAnimation()
-    : _head(nullptr), _current_keyframe(nullptr), _frame_start_time_ms(0), _playing(false),
-      _keyframe_has_started(false) {
+    : _arena(nullptr), _arena_bytes(0), _keyframes(nullptr), _num_keyframes(0), _keyframe_capacity(0),
+      _current_index(-1), _timeline_start_us(0), _keyframe_start_us(0), _carried_us(0), _max_lateness_us(0),
+      _playing(false), _timeline_started(false), _rate_q16(Q16_ONE), _reversed(false), _mode(ONCE), _passes(1),
+      _pass(0), _clock_us(0), _played_q16(0), _duration_us(0), _discontinuity(false), _pass_start_scalars(),
+      _tracks(), _tracks_index(-1), _index_start_us(nullptr), _index_stale(true), _seek_pending(false), _seek_us(0),
+      _seek_index(0), _start_at_pending(false), _start_at_us(0), _end_us(0), _baked_channels(nullptr),
+      _baked_frames(nullptr), _num_baked_channels(0), _num_baked_frames(0), _baked_frame_us(0) {
 }
 
 ServoAnimation::ServoAnimation(const ServoAnimation &other) : ServoAnimation() {
     // Copy the keyframes from the other animation
-    ServoKeyframe *current = other._head;
-    while (current != nullptr) {
-        add_keyframe(new ServoKeyframe(*current));
-        current = current->get_next();
+    _reserve(other._num_keyframes);
+    for (int i = 0; i < other._num_keyframes; i++) {
+        ServoKeyframe *keyframe = insert_keyframe(_num_keyframes, 0);
+        if (keyframe == nullptr) {
+            break;
+        }
+        *keyframe = other._keyframes[i];
+    }
+    if (other._baked_frames != nullptr) {
+        bake(other._baked_frame_us);
     }
 }
 
 ServoAnimation::~ServoAnimation() {
-    // Iterate through the keyframes and delete them
-    ServoKeyframe *current = _head;
-    while (current != nullptr) {
-        ServoKeyframe *next = current->get_next();
-        delete current;
-        current = next;
+    unbake();
+    delete[] _arena;
+}
+
+bool ServoAnimation::add_keyframe(ServoKeyframe *keyframe) {
+    ServoKeyframe *added = insert_keyframe(_num_keyframes, 0);
+    if (added != nullptr) {
+        *added = *keyframe;
     }
+    delete keyframe;
+    return added != nullptr;
 }
 
-void ServoAnimation::add_keyframe(ServoKeyframe *keyframe) {
-    // Find the first keyframe relative to the given keyframe
-    ServoKeyframe *given_head = keyframe;
-    while (given_head->get_prev() != nullptr) {
-        given_head = given_head->get_prev();
+ServoKeyframe *ServoAnimation::insert_keyframe(int index, unsigned long duration_ms) {
+    if (index < 0 || index > _num_keyframes) {
+        return nullptr;
     }
-    // Find the end of the linked list and add the new keyframe
-    ServoKeyframe *current = _head;
-    if (current == nullptr) {
-        _head = given_head;
-    } else {
-        while (current->get_next() != nullptr) {
-            current = current->get_next();
-        }
-        current->set_next(given_head);
-        given_head->set_prev(current);
+    if (_num_keyframes == _keyframe_capacity && !_reserve(max(2 * _keyframe_capacity, 4))) {
+        return nullptr;
     }
+    unbake();
+    _index_stale = true;
+
+    // Shift the keyframes after index back by one into the spare slot at the end
+    new (&_keyframes[_num_keyframes]) ServoKeyframe();
+    for (int i = _num_keyframes; i > index; i--) {
+        _keyframes[i] = _keyframes[i - 1];
+    }
+    _keyframes[index] = ServoKeyframe(duration_ms);
+    _num_keyframes++;
+    _link_keyframes(index);
+    return &_keyframes[index];
 }
 
-void ServoAnimation::play() {
+bool ServoAnimation::remove_keyframe(int index) {
+    if (index < 0 || index >= _num_keyframes) {
+        return false;
+    }
+    unbake();
+    _index_stale = true;
+
+    for (int i = index; i < _num_keyframes - 1; i++) {
+        _keyframes[i] = _keyframes[i + 1];
+    }
+    _num_keyframes--;
+    _link_keyframes(index);
+    return true;
+}
+
+bool ServoAnimation::_reserve(int capacity) {
+    if (capacity <= _keyframe_capacity) {
+        return true;
+    }
+    // The keyframes come first, their alignment covers the index after them
+    size_t   keyframes_bytes = capacity * sizeof(ServoKeyframe);
+    size_t   arena_bytes = keyframes_bytes + (capacity + 1) * sizeof(unsigned long);
+    uint8_t *arena = new (std::nothrow) uint8_t[arena_bytes];
+    if (arena == nullptr) {
+        return false;
+    }
+    ServoKeyframe *keyframes = reinterpret_cast<ServoKeyframe *>(arena);
+    for (int i = 0; i < _num_keyframes; i++) {
+        new (&keyframes[i]) ServoKeyframe(_keyframes[i]);
+    }
+    delete[] _arena;
+    _arena = arena;
+    _arena_bytes = arena_bytes;
+    _keyframes = keyframes;
+    _index_start_us = reinterpret_cast<unsigned long *>(arena + keyframes_bytes);
+    _keyframe_capacity = capacity;
+    _index_stale = true;
+    _link_keyframes(0);
+    return true;
+}
+
+void ServoAnimation::_link_keyframes(int first) {
+    for (int i = max(first - 1, 0); i < _num_keyframes; i++) {
+        _keyframes[i].set_prev(i > 0 ? &_keyframes[i - 1] : nullptr);
+        _keyframes[i].set_next(i + 1 < _num_keyframes ? &_keyframes[i + 1] : nullptr);
+    }
+}
+
+void ServoAnimation::play(float rate, PlaybackMode mode, unsigned int passes) {
     // Start the animation
     _playing = true;
-    _current_keyframe = _head;
-    _keyframe_has_started = false;
-    _frame_start_time_ms = millis();
+    _current_index = 0;
+    _timeline_started = false;
+    _carried_us = 0;
+    _max_lateness_us = 0;
+
+    _rate_q16 = q16_from_float(constrain(fabsf(rate), MIN_RATE, MAX_RATE));
+    _reversed = rate < 0.0f;
+    _mode = mode;
+    _passes = mode == ONCE ? 1 : passes;
+    _pass = 0;
+    _discontinuity = false;
+    _start_at_pending = false;
+    _tracks_index = -1;
+
+    // A seek() made before play() is kept, it says where to start
+    reindex();
+    _capture_start_pose();
 }
 
 void ServoAnimation::stop() {
     // Stop the animation
     _playing = false;
-    _current_keyframe = _head;
+    _current_index = 0;
 }
 
-void ServoAnimation::update() {
+void ServoAnimation::update(unsigned long now_us) {
     // Check if the animation is running, if not, stop
     if (!_playing) {
         return;
     }
 
+    if (!_plays_keyframes()) {
+        _update_clocked(now_us);
+        return;
+    }
+
     // Check if we reached the end of the animation, if so, stop
-    if (_current_keyframe == nullptr) {
+    if (_current_index >= _num_keyframes) {
+        _end_us = now_us;
         stop();
         return;
     }
 
-    // Check if the current keyframe has started, if not, start it
-    if (!_keyframe_has_started) {
-        // Start the keyframe
-        _keyframe_has_started = true;
+    // The timeline starts with the first update, or when start_timeline_at() says, and again wherever seek() moved it
+    if (!_timeline_started) {
+        _start_timeline(_start_at_pending ? _start_at_us : now_us);
+    } else if (_seek_pending) {
+        _start_timeline(now_us);
+    }
 
-        // Set the start time
-        _frame_start_time_ms = millis();
+    // Move past every keyframe that has ended. The next one starts where this one ends on the timeline, not now, so
+    // its ramps pick up the overshoot instead of the animation falling behind by it.
+    ServoKeyframe *keyframe = &_keyframes[_current_index];
+    unsigned long  duration_us = keyframe->get_duration() * 1000UL;
+    while (now_us - _keyframe_start_us >= duration_us) {
+        // Request the track of a keyframe that was passed over within this update too
+        keyframe->update();
+        if (_baked_frames == nullptr) {
+            keyframe->finish_keyframe();
+        }
 
-        // Setup all the servos in this keyframe
-        _current_keyframe->start_keyframe();
-    } // Check if we reached the end of the current keyframe, if so, move to the next keyframe
-    else if (millis() - _frame_start_time_ms > _current_keyframe->get_duration()) {
-        // Do one last update to make sure we got the tail end of the ramp
-        _current_keyframe->update();
-        _current_keyframe = _current_keyframe->get_next();
-        _keyframe_has_started = false;
-        return;
+        _keyframe_start_us += duration_us;
+        unsigned long lateness_us = now_us - _keyframe_start_us;
+        _carried_us += lateness_us;
+        _max_lateness_us = max(_max_lateness_us, lateness_us);
+
+        if (++_current_index >= _num_keyframes) {
+            if (_baked_frames != nullptr) {
+                _play_baked_frame(ULONG_MAX); // The final pose
+            }
+            _end_us = _keyframe_start_us;
+            stop();
+            return;
+        }
+        keyframe = &_keyframes[_current_index];
+        if (_baked_frames == nullptr) {
+            keyframe->start_keyframe(_keyframe_start_us);
+        }
+        duration_us = keyframe->get_duration() * 1000UL;
     }
 
     // Otherwise we're in the middle of a keyframe, update it
-    _current_keyframe->update();
+    keyframe->update();
+    if (_baked_frames != nullptr) {
+        _play_baked_frame(now_us - _timeline_start_us);
+    }
 }
 
 bool ServoAnimation::isPlaying() {
     return _playing;
 }
 
-ServoKeyframe *ServoAnimation::get_head() {
-    return _head;
+void ServoAnimation::start_timeline_at(unsigned long start_us) {
+    _start_at_us = start_us;
+    _start_at_pending = true;
+}
+
+unsigned long ServoAnimation::get_end_us() {
+    return _end_us;
+}
+
+void ServoAnimation::_start_timeline(unsigned long now_us) {
+    if (_seek_pending && (_index_start_us == nullptr || _seek_index >= _num_keyframes)) {
+        _seek_pending = false; // The keyframes changed since seek()
+    }
+    bool          first = !_timeline_started;
+    unsigned long t_us = _seek_pending ? _seek_us : 0;
+    _discontinuity |= _seek_pending;
+    _timeline_started = true;
+    _timeline_start_us = now_us - t_us;
+    _keyframe_start_us = _timeline_start_us;
+    _current_index = 0;
+    if (_seek_pending) {
+        _keyframe_start_us += _index_start_us[_seek_index];
+        _current_index = _seek_index;
+        _keyframes[_current_index].rewind_track();
+        _seek_pending = false;
+    }
+
+    if (_baked_frames != nullptr) {
+        if (first) {
+            // The first ramp of each servo starts from here
+            for (int i = 0; i < _num_baked_channels; i++) {
+                _baked_channels[i].start_us = _baked_channels[i].servo->get_current_us();
+            }
+        }
+    } else if (first && t_us == 0) {
+        _keyframes[_current_index].start_keyframe(_keyframe_start_us);
+    } else {
+        _resume_moves(t_us, now_us);
+    }
+}
+
+void ServoAnimation::_resume_moves(unsigned long t_us, unsigned long now_us) {
+    float      scalars[ServoContext::MAX_SERVOS];
+    ServoTrack tracks[ServoContext::MAX_SERVOS];
+    memcpy(scalars, _pass_start_scalars, sizeof(scalars));
+    _sample(t_us, scalars, tracks);
+    for (int id = 0; id < ServoContext::MAX_SERVOS; id++) {
+        const ServoTrack &track = tracks[id];
+        if (track.move != nullptr) {
+            // Ramp from where the servo was when the move started, as if it had been running all along
+            track.servo->set_scalar(track.start_scalar, 0);
+            track.move->start_servo(track.servo, now_us - (t_us - track.move_start_us));
+        }
+    }
+}
+
+bool ServoAnimation::seek(unsigned long t_us) {
+    int index = get_keyframe_index_at(t_us);
+    if (index < 0) {
+        return false;
+    }
+    _seek_us = t_us;
+    _seek_index = index;
+    _seek_pending = true;
+    return true;
+}
+
+bool ServoAnimation::seek_keyframe(int index) {
+    if (!_check_index() || index < 0 || index >= _num_keyframes) {
+        return false;
+    }
+    _seek_us = _index_start_us[index];
+    _seek_index = index;
+    _seek_pending = true;
+    return true;
+}
+
+void ServoAnimation::reindex() {
+    // The index grows with the keyframe array, so rebuilding it never touches the heap
+    if (_index_start_us == nullptr) {
+        return;
+    }
+    unsigned long start_us = 0;
+    for (int i = 0; i < _num_keyframes; i++) {
+        _index_start_us[i] = start_us;
+        start_us += _keyframes[i].get_duration() * 1000UL;
+    }
+    _index_start_us[_num_keyframes] = start_us;
+    _index_stale = false;
+}
+
+int ServoAnimation::get_num_keyframes() {
+    return _num_keyframes;
+}
+
+ServoKeyframe *ServoAnimation::get_keyframe(int index) {
+    if (index < 0 || index >= _num_keyframes) {
+        return nullptr;
+    }
+    return &_keyframes[index];
+}
+
+unsigned long ServoAnimation::get_keyframe_start_us(int index) {
+    if (!_check_index() || index < 0 || index > _num_keyframes) {
+        return 0;
+    }
+    return _index_start_us[index];
+}
+
+int ServoAnimation::get_keyframe_index_at(unsigned long t_us) {
+    if (!_check_index() || t_us >= _index_start_us[_num_keyframes]) {
+        return -1;
+    }
+    // The last keyframe that starts by t_us, keyframes with no duration before it are passed over
+    return std::upper_bound(_index_start_us, _index_start_us + _num_keyframes, t_us) - _index_start_us - 1;
+}
+
+bool ServoAnimation::_check_index() {
+    if (_index_stale) {
+        reindex();
+    }
+    return _index_start_us != nullptr;
+}
+
+void ServoAnimation::_capture_start_pose() {
+    for (int k = 0; k < _num_keyframes; k++) {
+        ServoMotor *servos[ServoContext::MAX_SERVOS];
+        int         num_servos = _keyframes[k].get_servos(servos, ServoContext::MAX_SERVOS);
+        for (int i = 0; i < num_servos; i++) {
+            _pass_start_scalars[servos[i]->get_id()] = servos[i]->get_scalar();
+        }
+    }
+}
+
+bool ServoAnimation::take_discontinuity() {
+    bool discontinuity = _discontinuity;
+    _discontinuity = false;
+    return discontinuity;
+}
+
+unsigned long ServoAnimation::get_duration_us() {
+    return _check_index() ? _index_start_us[_num_keyframes] : 0;
+}
+
+bool ServoAnimation::_plays_keyframes() {
+    return _rate_q16 == Q16_ONE && !_reversed && _mode == ONCE;
+}
+
+void ServoAnimation::_update_clocked(unsigned long now_us) {
+    if (!_timeline_started) {
+        _timeline_started = true;
+        _clock_us = _start_at_pending ? _start_at_us : now_us;
+        _played_q16 = 0;
+        _duration_us = get_duration_us();
+        _current_index = -1;
+        _set_baked_starts(); // The first moves start from the pose play() found the servos in
+        _discontinuity = _reversed;
+    }
+    if (_duration_us == 0) {
+        _end_us = _clock_us;
+        stop();
+        return;
+    }
+
+    // Advance the clock by the time since the last update at the playback rate. It only ever holds one pass, so it
+    // doesn't wrap however long the animation loops for.
+    uint64_t advance_q16 = (uint64_t)(now_us - _clock_us) * _rate_q16;
+    _clock_us = now_us;
+    if (_seek_pending) {
+        // Seek times are on the timeline, which a reversed pass plays from the end
+        _played_q16 = (uint64_t)(_pass_reversed(_pass) ? _duration_us - _seek_us : _seek_us) << 16;
+        _discontinuity = true;
+        _seek_pending = false;
+    }
+    _played_q16 += advance_q16;
+    uint64_t duration_q16 = (uint64_t)_duration_us << 16;
+    while (_played_q16 >= duration_q16) {
+        if (_passes != 0 && _pass + 1 >= _passes) {
+            _play_at(_pass_reversed(_pass) ? 0 : _duration_us); // The end of the last pass
+            _end_us = now_us - (unsigned long)((_played_q16 - duration_q16) / _rate_q16);
+            stop();
+            return;
+        }
+        _played_q16 -= duration_q16;
+        _start_next_pass();
+    }
+
+    unsigned long pass_us = (unsigned long)(_played_q16 >> 16);
+    _play_at(_pass_reversed(_pass) ? _duration_us - pass_us : pass_us);
+}
+
+void ServoAnimation::_start_next_pass() {
+    bool was_reversed = _pass_reversed(_pass);
+    _pass++;
+    if (_pass_reversed(_pass)) {
+        // A reversed pass starts from the final pose of the same start. It follows on from a forward pass, but a
+        // reversed pass before it ended at the start instead.
+        _discontinuity |= was_reversed;
+    } else {
+        // A forward pass starts its moves from wherever the last pass left the servos
+        _sample(was_reversed ? 0 : _duration_us, _pass_start_scalars, nullptr);
+        _set_baked_starts();
+        _tracks_index = -1;
+    }
+}
+
+void ServoAnimation::_set_baked_starts() {
+    for (int i = 0; i < _num_baked_channels; i++) {
+        ServoMotor *servo = _baked_channels[i].servo;
+        _baked_channels[i].start_us = servo->scalar_to_us(_pass_start_scalars[servo->get_id()]);
+    }
+}
+
+bool ServoAnimation::_pass_reversed(unsigned long pass) {
+    return _reversed != (_mode == PING_PONG && (pass & 1) != 0);
+}
+
+void ServoAnimation::_play_at(unsigned long t_us) {
+    int index = get_keyframe_index_at(t_us);
+    if (_baked_frames != nullptr) {
+        _play_baked_frame(t_us >= _duration_us ? ULONG_MAX : t_us);
+    } else {
+        // The end of the animation is the end of the last keyframe's moves
+        _advance_tracks(index >= 0 ? index : _num_keyframes - 1);
+        for (int id = 0; id < ServoContext::MAX_SERVOS; id++) {
+            const ServoTrack &track = _tracks[id];
+            if (track.servo != nullptr) {
+                float scalar = track.move->sample_servo_at(track.servo, t_us - track.move_start_us, track.start_scalar,
+                                                           track.progress_rate);
+                track.servo->set_us(track.servo->scalar_to_us(scalar), 0);
+            }
+        }
+    }
+
+    // Tracks play at their own speed, from whichever end the timeline enters the keyframe
+    if (index != _current_index && index >= 0) {
+        _keyframes[index].rewind_track();
+        _keyframes[index].update();
+    }
+    _current_index = index;
+}
+
+bool ServoAnimation::bake(unsigned long frame_us) {
+    unbake();
+    if (_num_keyframes == 0 || frame_us == 0) {
+        return false;
+    }
+
+    // Find the servos the animation moves and how long it is
+    ServoMotor   *servos[ServoContext::MAX_SERVOS];
+    int           num_servos = 0;
+    unsigned long duration_us = 0;
+    for (int k = 0; k < _num_keyframes; k++) {
+        ServoMotor *keyframe_servos[ServoContext::MAX_SERVOS];
+        int         num_keyframe_servos = _keyframes[k].get_servos(keyframe_servos, ServoContext::MAX_SERVOS);
+        for (int i = 0; i < num_keyframe_servos; i++) {
+            bool known = false;
+            for (int j = 0; j < num_servos; j++) {
+                known |= servos[j] == keyframe_servos[i];
+            }
+            if (!known && num_servos < ServoContext::MAX_SERVOS) {
+                servos[num_servos++] = keyframe_servos[i];
+            }
+        }
+        duration_us += _keyframes[k].get_duration() * 1000UL;
+    }
+    if (num_servos == 0) {
+        return false;
+    }
+
+    unsigned long num_frames = duration_us / frame_us + 2; // The last frame holds the final pose
+    if (num_frames > UINT16_MAX) {
+        return false;
+    }
+    _baked_channels = new (std::nothrow) BakedChannel[num_servos];
+    _baked_frames = new (std::nothrow) uint16_t[num_frames * num_servos];
+    if (_baked_channels == nullptr || _baked_frames == nullptr) {
+        unbake();
+        return false;
+    }
+    _num_baked_channels = num_servos;
+    _num_baked_frames = num_frames;
+    _baked_frame_us = frame_us;
+
+    // The first ramp of each servo depends on where the servo is on play, so store its eased progress in Q14
+    for (int c = 0; c < num_servos; c++) {
+        BakedChannel &channel = _baked_channels[c];
+        channel.servo = servos[c];
+        channel.start_us = servos[c]->get_current_us();
+
+        unsigned long ramp_start_us = 0;
+        int           k = 0;
+        float         target_scalar;
+        ramp_mode     mode;
+        unsigned long ramp_duration_ms;
+        while (!_keyframes[k].get_servo_target(servos[c], &target_scalar, &mode, &ramp_duration_ms)) {
+            ramp_start_us += _keyframes[k++].get_duration() * 1000UL;
+        }
+        unsigned long ramp_duration_us = ramp_duration_ms * 1000UL;
+        unsigned long ramp_end_us = ramp_start_us + ramp_duration_us;
+
+        // Past the end of the first ramp every frame has to be the same wherever the servo started, so the ramp can't
+        // be cut short by the servo's next move or by the end of the animation
+        unsigned long next_move_us = ramp_start_us + _keyframes[k].get_duration() * 1000UL;
+        int           next = k + 1;
+        float         next_scalar;
+        ramp_mode     next_mode;
+        while (next < _num_keyframes && !_keyframes[next].get_servo_target(servos[c], &next_scalar, &next_mode)) {
+            next_move_us += _keyframes[next++].get_duration() * 1000UL;
+        }
+        if (ramp_end_us > duration_us || (next < _num_keyframes && next_move_us < ramp_end_us)) {
+            unbake();
+            return false;
+        }
+
+        channel.lead_in_frames = (uint16_t)min((ramp_end_us + frame_us - 1) / frame_us, num_frames - 1);
+        channel.lead_in_target_us = servos[c]->scalar_to_us(target_scalar);
+        EaseFunction ease = ease_function(mode);
+        for (unsigned long f = 0; f < channel.lead_in_frames; f++) {
+            unsigned long t_us = f * frame_us;
+            q16_t         progress = 0;
+            if (t_us >= ramp_start_us) {
+                progress = ease(q16_progress(t_us - ramp_start_us, q16_progress_rate(ramp_duration_us)));
+            }
+            _baked_frames[f * num_servos + c] = (uint16_t)(int16_t)((progress + 2) >> 2);
+        }
+    }
+
+    // After its first ramp a servo's pulse widths no longer depend on where it started
+    for (unsigned long f = 0; f < num_frames; f++) {
+        float scalars[ServoContext::MAX_SERVOS] = {};
+        sample_at(f == num_frames - 1 ? duration_us : f * frame_us, scalars);
+        for (int c = 0; c < num_servos; c++) {
+            if (f >= _baked_channels[c].lead_in_frames) {
+                _baked_frames[f * num_servos + c] = servos[c]->scalar_to_us(scalars[servos[c]->get_id()]);
+            }
+        }
+    }
+    return true;
+}
+
+void ServoAnimation::unbake() {
+    delete[] _baked_channels;
+    delete[] _baked_frames;
+    _baked_channels = nullptr;
+    _baked_frames = nullptr;
+    _num_baked_channels = 0;
+    _num_baked_frames = 0;
+}
+
+bool ServoAnimation::is_baked() {
+    return _baked_frames != nullptr;
+}
+
+size_t ServoAnimation::get_arena_bytes() {
+    return _arena_bytes;
 }
 
-void ServoAnimation::set_head(ServoKeyframe *head) {
-    stop(); // In case we're playing
-    _head = head;
-    _current_keyframe = _head;
+size_t ServoAnimation::get_baked_bytes() {
+    return _num_baked_channels * (sizeof(BakedChannel) + _num_baked_frames * sizeof(uint16_t));
+}
+
+void ServoAnimation::_play_baked_frame(unsigned long t_us) {
+    unsigned long   frame = min(t_us / _baked_frame_us, _num_baked_frames - 1);
+    const uint16_t *values = &_baked_frames[frame * _num_baked_channels];
+    for (int c = 0; c < _num_baked_channels; c++) {
+        BakedChannel &channel = _baked_channels[c];
+        int           us = values[c];
+        if (frame < channel.lead_in_frames) {
+            us = channel.start_us + (((channel.lead_in_target_us - channel.start_us) * (int16_t)values[c]) >> 14);
+        }
+        channel.servo->set_us(us, 0);
+    }
+}
+
+bool ServoAnimation::sample_at(unsigned long t_us, float *scalars) {
+    return _sample(t_us, scalars, nullptr) >= 0;
+}
+
+void ServoAnimation::_advance_tracks(int index) {
+    // Moves are only ever added on, so going back a keyframe means following the tracks from the start again
+    if (index < _tracks_index) {
+        _tracks_index = -1;
+    }
+    if (_tracks_index < 0) {
+        for (int id = 0; id < ServoContext::MAX_SERVOS; id++) {
+            _tracks[id].move = nullptr;
+            _tracks[id].servo = nullptr;
+        }
+    }
+    for (int k = _tracks_index + 1; k <= index; k++) {
+        _add_moves(k, _index_start_us[k], _tracks, _pass_start_scalars);
+    }
+    _tracks_index = index;
+}
+
+void ServoAnimation::_add_moves(int index, unsigned long keyframe_start_us, ServoTrack *tracks,
+                                const float *start_scalars) {
+    ServoKeyframe *keyframe = &_keyframes[index];
+    ServoMotor    *servos[ServoContext::MAX_SERVOS];
+    int            num_servos = keyframe->get_servos(servos, ServoContext::MAX_SERVOS);
+    for (int i = 0; i < num_servos; i++) {
+        ServoTrack &track = tracks[servos[i]->get_id()];
+        float       start_scalar = start_scalars[servos[i]->get_id()];
+        if (track.move != nullptr) {
+            start_scalar = track.move->sample_servo_at(servos[i], keyframe_start_us - track.move_start_us,
+                                                       track.start_scalar, track.progress_rate);
+        }
+        track.move = keyframe;
+        track.servo = servos[i];
+        track.move_start_us = keyframe_start_us;
+        track.start_scalar = start_scalar;
+        track.progress_rate = keyframe->get_servo_progress_rate(servos[i]);
+    }
+}
+
+int ServoAnimation::_sample(unsigned long t_us, float *scalars, ServoTrack *tracks) {
+    // Follow each servo's track to the last move that starts by t_us
+    ServoTrack local_tracks[ServoContext::MAX_SERVOS];
+    if (tracks == nullptr) {
+        tracks = local_tracks;
+    }
+    for (int id = 0; id < ServoContext::MAX_SERVOS; id++) {
+        tracks[id].move = nullptr;
+        tracks[id].servo = nullptr;
+    }
+
+    unsigned long keyframe_start_us = 0;
+    int           index = 0;
+    for (; index < _num_keyframes && keyframe_start_us <= t_us; index++) {
+        _add_moves(index, keyframe_start_us, tracks, scalars);
+        keyframe_start_us += _keyframes[index].get_duration() * 1000UL;
+    }
+
+    for (int id = 0; id < ServoContext::MAX_SERVOS; id++) {
+        const ServoTrack &track = tracks[id];
+        if (track.move != nullptr) {
+            scalars[id] = track.move->sample_servo_at(track.servo, t_us - track.move_start_us, track.start_scalar,
+                                                      track.progress_rate);
+        }
+    }
+    return t_us < keyframe_start_us ? index - 1 : -1;
+}
+
+uint32_t ServoAnimation::get_channel_mask() {
+    uint32_t mask = 0;
+    for (int k = 0; k < _num_keyframes; k++) {
+        ServoMotor *servos[ServoContext::MAX_SERVOS];
+        int         num_servos = _keyframes[k].get_servos(servos, ServoContext::MAX_SERVOS);
+        for (int i = 0; i < num_servos; i++) {
+            mask |= (uint32_t)1 << servos[i]->get_id();
+        }
+    }
+    return mask;
+}
+
+void ServoAnimation::drop_held_servos() {
+    unbake();
+    // The keyframe of each servo's latest move, nullptr until it has one
+    ServoKeyframe *last_moves[ServoContext::MAX_SERVOS] = {};
+    for (int k = 0; k < _num_keyframes; k++) {
+        ServoKeyframe *keyframe = &_keyframes[k];
+        ServoMotor    *servos[ServoContext::MAX_SERVOS];
+        int         num_servos = keyframe->get_servos(servos, ServoContext::MAX_SERVOS);
+        for (int i = 0; i < num_servos; i++) {
+            ServoMotor   *servo = servos[i];
+            int           id = servo->get_id();
+            float         scalar, last_scalar;
+            ramp_mode     mode, last_mode;
+            unsigned long duration_ms, last_duration_ms;
+            keyframe->get_servo_target(servo, &scalar, &mode, &duration_ms);
+
+            // The servo is holding if its last move ended with its keyframe and this one goes to the same place
+            ServoKeyframe *last = last_moves[id];
+            if (last != nullptr && mode != CATMULL_ROM && duration_ms == keyframe->get_duration() &&
+                last->get_servo_target(servo, &last_scalar, &last_mode, &last_duration_ms) &&
+                last_duration_ms <= last->get_duration() &&
+                servo->scalar_to_us(scalar) == servo->scalar_to_us(last_scalar)) {
+                keyframe->remove_servo(servo);
+                continue;
+            }
+            last_moves[id] = keyframe;
+        }
+    }
+}
+
+unsigned long ServoAnimation::get_carried_us() {
+    return _carried_us;
+}
+
+unsigned long ServoAnimation::get_max_lateness_us() {
+    return _max_lateness_us;
 }
 
 void ServoAnimation::printDebugInfo() {
     Serial.println("--------- ServoAnimation ---------");
     Serial.print("Playing: ");
     Serial.println(_playing);
-    Serial.print("Head Keyframe: ");
-    Serial.println((unsigned int) _head, HEX);
+    Serial.printf("Keyframes: %d (capacity %d, arena %u bytes)\n", _num_keyframes, _keyframe_capacity,
+                  (unsigned int)_arena_bytes);
     Serial.print("Current Keyframe: ");
-    Serial.println((unsigned int) _current_keyframe, HEX);
-    if (_head != nullptr) {
+    Serial.println(_current_index);
+    Serial.printf("Timing error carried/max (us): %lu/%lu\n", _carried_us, _max_lateness_us);
+    if (_num_keyframes > 0) {
         Serial.print("Head Keyframe Duration: ");
-        Serial.println(_head->get_duration());
-        if (_head->get_next() != nullptr) {
+        Serial.println(_keyframes[0].get_duration());
+        if (_num_keyframes > 1) {
             Serial.print("Next Keyframe Duration: ");
-            Serial.println(_head->get_next()->get_duration());
+            Serial.println(_keyframes[1].get_duration());
         }
     }
 }
@@ -143,23 +742,31 @@ bool ServoAnimation::save(fs::FS &filesystem, const char *filename) {
     }
 
     // Loop through the keyframes and write each one to the file
-    ServoKeyframe *current = _head;
     bool success = true;
-    while (current != nullptr) {
+    for (int k = 0; k < _num_keyframes; k++) {
         success &= 0 < animation_file.println(_SERIALIZED_KEYFRAME_START);
-        success &= 0 < animation_file.println(current->serialize().c_str());
+        success &= 0 < animation_file.println(_keyframes[k].serialize().c_str());
         success &= 0 < animation_file.println(_SERIALIZED_KEYFRAME_END);
         if (!success) {
             Serial.println("Write failed");
             break;
         }
-        current = current->get_next();
     }
 
     animation_file.close();
     return success;
 }
 
+void ServoAnimation::_read_line(fs::File &file, char *line, size_t size) {
+    size_t length = file.readBytesUntil('\n', line, size - 1);
+    line[length] = '\0';
+    if (length == size - 1) {
+        // The buffer filled before the end of the line, the rest of it mustn't be read as a line of its own
+        while (file.available() && file.read() != '\n') {
+        }
+    }
+}
+
 ServoAnimation* ServoAnimation::load(fs::FS &filesystem, const char *filename,
                                                      ServoContext &servo_context, DfMp3 *_dfmp3) {
     File animation_file = filesystem.open(filename, FILE_READ);
@@ -168,23 +775,42 @@ ServoAnimation* ServoAnimation::load(fs::FS &filesystem, const char *filename,
         return nullptr;
     }
 
-    // Read the keyframes from the file and create a new animation from the data
-    ServoAnimation *animation(new ServoAnimation());
-    String          keyframe_str;
+    // Count the keyframes first, so the arena is allocated once at its final size
+    char line[ServoKeyframe::MAX_SERIALIZED_LINE];
+    int  num_keyframes = 0;
     while (animation_file.available()) {
-        String line = animation_file.readStringUntil('\n');
-        if (line.indexOf(_SERIALIZED_KEYFRAME_START) > -1) {
-            keyframe_str.clear();
-        } else if (line.indexOf(_SERIALIZED_KEYFRAME_END) > -1) {
-            ServoKeyframe *keyframe = ServoKeyframe::deserialize(keyframe_str.c_str(), servo_context, _dfmp3);
-            if (keyframe != nullptr) {
-                animation->add_keyframe(keyframe);
-            }
-        } else {
-            keyframe_str += line + "\n";
+        _read_line(animation_file, line, sizeof(line));
+        if (strstr(line, _SERIALIZED_KEYFRAME_START) != nullptr) {
+            num_keyframes++;
         }
     }
+    ServoAnimation *animation = new (std::nothrow) ServoAnimation();
+    if (animation == nullptr || !animation->_reserve(num_keyframes) || !animation_file.seek(0)) {
+        Serial.println("Not enough memory to load the animation");
+        delete animation;
+        animation_file.close();
+        return nullptr;
+    }
+
+    // Parse the keyframes a line at a time straight into the arena
+    ServoKeyframe *keyframe = nullptr;
+    ServoMotor    *servo = nullptr;
+    while (animation_file.available()) {
+        _read_line(animation_file, line, sizeof(line));
+        if (strstr(line, _SERIALIZED_KEYFRAME_START) != nullptr) {
+            keyframe = animation->insert_keyframe(animation->_num_keyframes, 0);
+            servo = nullptr;
+        } else if (strstr(line, _SERIALIZED_KEYFRAME_END) != nullptr) {
+            keyframe = nullptr;
+        } else if (keyframe != nullptr) {
+            keyframe->deserialize_line(line, servo_context, _dfmp3, &servo);
+        }
+    }
+    if (keyframe != nullptr) {
+        animation->remove_keyframe(animation->_num_keyframes - 1); // The file ended part way through it
+    }
 
     animation_file.close();
+    animation->drop_held_servos();
     return animation;
-}
\ No newline at end of file
+}
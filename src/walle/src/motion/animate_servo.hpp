@@ -16,18 +16,52 @@
 #include <FS.h>
 #include <SPIFFS.h>
 #include <Arduino.h>
-#include <Ramp.h>
-#include <sstream>
+#include "easing.hpp"
 #include <string>
-#include <iostream>
+#include <new>
+#include <algorithm>
+#include <type_traits>
 #include "servo_keyframe.hpp"
 #include "servo_context.hpp"
 
 /**
  * @brief Class representing a servo animation.
+ *
+ * An animation plays forward once at its recorded speed by default, running each keyframe's moves as ramps on the
+ * servos' bank. It can also be played at another rate, in reverse, looped or ping-ponged. Those are applied to the
+ * timeline clock, the keyframes are never changed. Each update then works out the time on the timeline and sets the
+ * servos to where the animation has them at that time, from the baked frames if there are any, otherwise from each
+ * servo's current move. The moves are kept between updates and only followed on from keyframe to keyframe, so an
+ * update doesn't walk the keyframes. They are followed again from the start at the start of a pass, and whenever the
+ * timeline goes back a keyframe, in reverse or after a seek().
+ *
+ * The keyframes are stored by value in one array, addressed by their number. The array doubles when it fills, so
+ * adding a keyframe to the end is O(1) on average, and inserting or removing one shifts the keyframes after it. Each
+ * keyframe's next and previous pointers are set to its neighbours in the array whenever they move. Next to the array
+ * is an index of prefix-summed start times, which finds the keyframe playing at a time with a binary search, so
+ * seek() can jump anywhere in a long animation. The index is rebuilt by play() and reindex().
+ *
+ * The keyframe array and the index share one arena, a single heap block that holds all of the animation's keyframe
+ * data and is freed in one go. load() counts the keyframes before it parses them, so a loaded animation takes exactly
+ * one allocation of its final size and nothing is left behind in the heap in between. The baked frames are separate.
+ *
+ * NOTE: Pointers to keyframes are only good until the next keyframe is added, inserted or removed, and keyframes
+ * shouldn't be added or removed while the animation plays.
  */
 class ServoAnimation {
   public:
+    /**
+     * @brief How the timeline carries on at the end of the animation.
+     */
+    enum PlaybackMode {
+        ONCE,      ///< Play through once and stop.
+        LOOP,      ///< Start again from the other end. Each pass starts its moves from where the last one ended.
+        PING_PONG, ///< Turn around and play back the other way.
+    };
+
+    static constexpr float MIN_RATE = 0.25f; ///< Slowest playback rate, as a multiple of the recorded speed
+    static constexpr float MAX_RATE = 4.0f;  ///< Fastest playback rate, as a multiple of the recorded speed
+
     /**
      * @brief Default constructor.
      */
@@ -35,28 +69,57 @@ class ServoAnimation {
 
     /**
      * @brief Copy constructor. Iterates through the keyframes of the other animation and adds coppies of them to this
-     * one.
+     * one. If the other animation is baked, this one is baked with the same frame period.
      * @param other The ServoAnimation object to copy from.
      */
     ServoAnimation(const ServoAnimation &other);
 
+    /**
+     * @brief Not assignable, the arena and the baked frames are owned by one animation. Copy construct instead.
+     */
+    ServoAnimation &operator=(const ServoAnimation &) = delete;
+
     /**
      * @brief Destructor.
      */
     ~ServoAnimation();
 
     /**
-     * @brief Adds a keyframe to the animation. The given keyframe does not have to be the first keyframe in a linked
-     * list. This function will add all keyframes in the linked list to the animation by searching for the head of the
-     * given list and appending it to the tail of the current list.
+     * @brief Adds a keyframe to the end of the animation. The keyframe is copied into the animation's array and the
+     * given object is deleted, so it must have been made with new and can't be used afterwards. A baked animation is
+     * unbaked, call bake() again once all keyframes are added.
      * @param keyframe The keyframe to add.
+     * @return True if the keyframe was added, false if there wasn't memory for it.
      */
-    void add_keyframe(ServoKeyframe *keyframe);
+    bool add_keyframe(ServoKeyframe *keyframe);
 
     /**
-     * @brief Starts playing the animation.
+     * @brief Inserts an empty keyframe into the animation, moving the keyframes from index on back by one. A baked
+     * animation is unbaked.
+     * @param index The number the new keyframe gets, get_num_keyframes() adds it to the end.
+     * @param duration_ms The duration of the keyframe in milliseconds.
+     * @return The new keyframe, or nullptr if index is out of range or there wasn't memory for it.
      */
-    void play();
+    ServoKeyframe *insert_keyframe(int index, unsigned long duration_ms);
+
+    /**
+     * @brief Removes a keyframe from the animation and deletes it, moving the keyframes after it forward by one. A
+     * baked animation is unbaked.
+     * @param index The number of the keyframe.
+     * @return True if the keyframe was removed, false if there is no such keyframe.
+     */
+    bool remove_keyframe(int index);
+
+    /**
+     * @brief Starts playing the animation. The timeline starts at the next update().
+     *
+     * @param rate The speed of the timeline as a multiple of the recorded speed, limited to MIN_RATE to MAX_RATE
+     * either way. A negative rate plays in reverse, starting from the end of the animation.
+     * @param mode What to do at the end of the animation.
+     * @param passes The number of times to play through for LOOP and PING_PONG, one way each. 0 plays until stopped.
+     * ONCE is always one pass.
+     */
+    void play(float rate = 1.0f, PlaybackMode mode = ONCE, unsigned int passes = 0);
 
     /**
      * @brief Stops the animation.
@@ -65,8 +128,14 @@ class ServoAnimation {
 
     /**
      * @brief Updates the animation. This function should be called periodically to update the animation.
+     *
+     * The keyframes are laid out on a timeline that starts at the first update after play(). Each keyframe starts
+     * exactly when the one before it ends on that timeline, however late the update that notices is, so the time
+     * between updates never adds up over a long animation. A single update moves past as many keyframes as have ended.
+     *
+     * @param now_us The current micros() time.
      */
-    void update();
+    void update(unsigned long now_us);
 
     /**
      * @brief Checks if the animation is currently playing.
@@ -75,17 +144,167 @@ class ServoAnimation {
     bool isPlaying();
 
     /**
-     * @brief Gets the head keyframe of the animation.
-     * @return The head keyframe.
+     * @brief Starts the timeline at a given time instead of at the next update(). Call it after play(). A time in the
+     * past picks the animation up part way through, so one animation can follow another without a gap.
+     * @param start_us The micros() time the timeline starts at, not later than the next update().
+     */
+    void start_timeline_at(unsigned long start_us);
+
+    /**
+     * @brief Gets the time the animation ended at on its timeline, which is normally a little before the update that
+     * noticed. Only meaningful once the animation has stopped by itself.
+     * @return The micros() time the last pass ended at.
+     */
+    unsigned long get_end_us();
+
+    /**
+     * @brief Moves the timeline to a time into the animation. Before play() it sets where the next play starts, and
+     * while playing the timeline jumps there at the next update(). Either way the servos are put where the animation
+     * has them at that time, as if it had played from the start, and the moves running then carry on from there.
+     *
+     * The keyframe is found in O(log n) from the index. The moves running at that time are worked out in one pass over
+     * the keyframes before it when the jump is made. While the animation plays, seek through ServoPlayer::seek().
+     *
+     * @param t_us The time into the animation in microseconds. Reversed playback counts it from the start too.
+     * @return True if the timeline will jump, false if t_us is past the end or there is no index.
+     */
+    bool seek(unsigned long t_us);
+
+    /**
+     * @brief Moves the timeline to the start of a keyframe. See seek().
+     * @param index The number of the keyframe, 0 is the first.
+     * @return True if the timeline will jump, false if there is no such keyframe.
+     */
+    bool seek_keyframe(int index);
+
+    /**
+     * @brief Rebuilds the keyframe index. Call it after changing the keyframes' durations directly, before using the
+     * index. play() always rebuilds it, and adding or removing keyframes marks it to be rebuilt on its next use.
+     */
+    void reindex();
+
+    /**
+     * @brief Gets the number of keyframes.
+     * @return The number of keyframes.
+     */
+    int get_num_keyframes();
+
+    /**
+     * @brief Gets a keyframe by its number in O(1). Changing the keyframe doesn't update the baked frames, so unbake()
+     * an animation before editing its keyframes and bake() it again after.
+     * @param index The number of the keyframe, 0 is the first.
+     * @return The keyframe, or nullptr if there is no such keyframe.
+     */
+    ServoKeyframe *get_keyframe(int index);
+
+    /**
+     * @brief Gets the time a keyframe starts at, from the index.
+     * @param index The number of the keyframe. get_num_keyframes() gives the end of the animation.
+     * @return The time into the animation in microseconds, 0 if there is no such keyframe.
+     */
+    unsigned long get_keyframe_start_us(int index);
+
+    /**
+     * @brief Finds the keyframe playing at a time into the animation, with a binary search of the index.
+     * @param t_us The time into the animation in microseconds.
+     * @return The number of the keyframe, or -1 if t_us is past the end or there is no index.
+     */
+    int get_keyframe_index_at(unsigned long t_us);
+
+    /**
+     * @brief Checks if the animation jumped since the last call, and clears the flag. A reversed animation starts at
+     * its final pose, and a reversed loop jumps back to it at the start of each pass, so the servos need to be blended
+     * over, e.g. with ServoMixer::start_crossfade().
+     * @return True if the servos were set somewhere other than where the animation last had them.
+     */
+    bool take_discontinuity();
+
+    /**
+     * @brief Gets the length of one pass of the animation at its recorded speed.
+     * @return The total duration of the keyframes in microseconds.
+     */
+    unsigned long get_duration_us();
+
+    /**
+     * @brief Bakes the animation into one pulse width per servo per frame, trading memory for a constant per-tick cost.
+     *
+     * A baked animation plays by reading the frame for the current time and setting each servo it moves straight to
+     * that pulse width, however many keyframes and servos the keyframes hold. Tracks and timing work as before. It
+     * takes 2 bytes per servo per frame, e.g. 1.2 kB for two servos over 6 s at 50 frames per second.
+     *
+     * A servo's first ramp starts from wherever the servo is when the animation plays, so until that ramp ends its
+     * frames hold the eased progress of the ramp instead of a pulse width and the pulse width is worked out on play.
+     *
+     * Keyframes changed after baking are not picked up until bake() is called again.
+     *
+     * @param frame_us The time between frames in microseconds, normally the servo PWM period.
+     * @return True if the animation was baked, false if it has no servos to move, there isn't memory for the frames,
+     * or a servo's first move is cut short by its next move or the end of the animation.
+     */
+    bool bake(unsigned long frame_us);
+
+    /**
+     * @brief Frees the baked frames, the animation plays from its keyframes again.
+     */
+    void unbake();
+
+    /**
+     * @brief Checks if the animation is baked.
+     * @return True if the animation plays from baked frames, false if it plays from its keyframes.
+     */
+    bool is_baked();
+
+    /**
+     * @brief Gets the size of the arena holding the keyframes and the index.
+     * @return The size of the arena in bytes, 0 if no keyframe has been added.
+     */
+    size_t get_arena_bytes();
+
+    /**
+     * @brief Gets the memory the baked frames take.
+     * @return The size of the baked frames and their channels in bytes, 0 if the animation isn't baked.
+     */
+    size_t get_baked_bytes();
+
+    /**
+     * @brief Works out where the animation puts the servos at a time into it, from the keyframes alone. Nothing is
+     * played and the servos are not touched, so it can be called at any time, even while the animation plays.
+     *
+     * Each servo follows its own moves, so a move longer than its keyframe carries on through the keyframes after it.
+     * Servos the animation doesn't move keep the value they had.
+     *
+     * @param t_us The time since the start of the animation in microseconds.
+     * @param[in,out] scalars One scalar per servo ID, ServoContext::MAX_SERVOS of them. On entry, where the servos are
+     * when the animation starts. On return, where they are at t_us.
+     * @return True if t_us is within the animation, false if it is past the end. The scalars then hold the final pose.
+     */
+    bool sample_at(unsigned long t_us, float *scalars);
+
+    /**
+     * @brief Gets the servos the animation moves.
+     * @return One bit per servo ID, bit 0 is ID 0. The same layout as a ServoMixer::ChannelMask.
+     */
+    uint32_t get_channel_mask();
+
+    /**
+     * @brief Removes every move that leaves a servo where its previous move already put it, so each keyframe only
+     * holds the servos that actually move at it. Keyframes recorded as full poses shrink to the servos that changed.
+     * Moves with their own duration or CATMULL_ROM are kept, since they shape the moves around them.
+     */
+    void drop_held_servos();
+
+    /**
+     * @brief Gets how far behind the timeline the updates noticed keyframe ends, added up since play(). Without the
+     * timeline this is how far the animation would have drifted behind its audio.
+     * @return The timing error carried into later keyframes in microseconds.
      */
-    ServoKeyframe *get_head();
+    unsigned long get_carried_us();
 
     /**
-     * @brief Sets the head keyframe of the animation. The user is responsible for deleting the old head keyframe if
-     * necessary.
-     * @param head The head keyframe to set.
+     * @brief Gets the latest any update noticed a keyframe end since play().
+     * @return The largest timing error of a single keyframe in microseconds.
      */
-    void set_head(ServoKeyframe *head);
+    unsigned long get_max_lateness_us();
 
     /**
      * @brief Saves the animation to a file.
@@ -96,7 +315,9 @@ class ServoAnimation {
     bool save(fs::FS &filesystem, const char* filename);
 
     /**
-     * @brief Loads an animation from a file.
+     * @brief Loads an animation from a file. Files recorded as full poses are converted to per servo moves with
+     * drop_held_servos(). The file is read twice, once to count the keyframes for the arena and once to parse them a
+     * line at a time into it, so the only allocations are the animation and its arena.
      * @param filesystem The file system to load from.
      * @param filename The name of the file to load.
      * @param servo_context The servo context to use for loading.
@@ -112,11 +333,183 @@ class ServoAnimation {
     void printDebugInfo();
 
   private:
-    ServoKeyframe *_head; /**< The head keyframe of the animation. */
-    ServoKeyframe *_current_keyframe; /**< The current keyframe being played. */
-    unsigned long _frame_start_time_ms; /**< The start time of the current frame. */
+    /**
+     * @brief Where a servo is on its track at some time into the animation.
+     */
+    struct ServoTrack {
+        ServoKeyframe *move;          /**< The keyframe of the servo's latest move, nullptr if it hasn't moved. */
+        ServoMotor    *servo;         /**< The servo, nullptr if it hasn't moved. */
+        unsigned long  move_start_us; /**< The time into the animation the move starts at. */
+        float          start_scalar;  /**< Where the servo is when the move starts. */
+        uint64_t       progress_rate; /**< The move's ServoKeyframe::get_servo_progress_rate(). */
+    };
+
+    /**
+     * @brief One servo of a baked animation.
+     */
+    struct BakedChannel {
+        ServoMotor *servo;             /**< The servo the channel drives. */
+        uint16_t    lead_in_frames;    /**< Frames before the end of the servo's first ramp, they hold Q14 progress. */
+        int         lead_in_target_us; /**< The target of the servo's first ramp. */
+        int         start_us;          /**< Where the servo was when the timeline started. */
+    };
+
+    /**
+     * @brief Rebuilds the index if keyframes were added or removed since it was built.
+     * @return True if there is an index.
+     */
+    bool _check_index();
+
+    /**
+     * @brief Grows the arena to hold the keyframes and index of at least a number of keyframes.
+     * @param capacity The number of keyframes to make room for.
+     * @return True if there is room, false if there wasn't memory for it. The keyframes are kept either way.
+     */
+    bool _reserve(int capacity);
+
+    /**
+     * @brief Points the keyframes from first on at their neighbours in the array.
+     * @param first The number of the first keyframe that moved.
+     */
+    void _link_keyframes(int first);
+
+    /**
+     * @brief Stores where every servo the animation moves is now in _pass_start_scalars, as the pose the animation
+     * starts from.
+     */
+    void _capture_start_pose();
+
+    /**
+     * @brief Starts the timeline of the keyframes, at the start or where seek() moved it to.
+     * @param now_us The current micros() time.
+     */
+    void _start_timeline(unsigned long now_us);
+
+    /**
+     * @brief Starts every servo on the move it is on at a time into the animation, picked up part way through.
+     * @param t_us The time into the animation in microseconds.
+     * @param now_us The current micros() time, which is t_us on the timeline.
+     */
+    void _resume_moves(unsigned long t_us, unsigned long now_us);
+
+    /**
+     * @brief Checks if the animation plays forward once at the recorded speed, running the keyframes as ramps.
+     * @return False if the timeline clock is scaled, reversed or wraps, so the timeline is sampled every update.
+     */
+    bool _plays_keyframes();
+
+    /**
+     * @brief Plays the animation off the scaled timeline clock, for anything but _plays_keyframes().
+     * @param now_us The current micros() time.
+     */
+    void _update_clocked(unsigned long now_us);
+
+    /**
+     * @brief Moves on to the next pass of a looping or ping-ponging animation.
+     */
+    void _start_next_pass();
+
+    /**
+     * @brief Starts the lead-in of every baked servo from where the current pass starts it.
+     */
+    void _set_baked_starts();
+
+    /**
+     * @brief Checks which way a pass plays.
+     * @param pass The pass, 0 is the first.
+     * @return True if the pass runs from the end of the animation back to its start.
+     */
+    bool _pass_reversed(unsigned long pass);
+
+    /**
+     * @brief Sets the servos to where the current pass has them at a time into the animation, and requests the track
+     * of a keyframe the timeline has just entered.
+     * @param t_us The time since the start of the animation in microseconds, up to its duration.
+     */
+    void _play_at(unsigned long t_us);
+
+    /**
+     * @brief Follows _tracks on to a keyframe, from the start if it is before the last one they were followed to.
+     * @param index The number of the keyframe.
+     */
+    void _advance_tracks(int index);
+
+    /**
+     * @brief Adds a keyframe's moves to the servos' tracks. A move starts from wherever the servo's move before it has
+     * it when the keyframe starts, which may still be part way through.
+     * @param index The number of the keyframe.
+     * @param keyframe_start_us The time into the animation the keyframe starts at.
+     * @param[in,out] tracks One ServoTrack per servo ID.
+     * @param start_scalars One scalar per servo ID, where the servos are when the animation starts.
+     */
+    void _add_moves(int index, unsigned long keyframe_start_us, ServoTrack *tracks, const float *start_scalars);
+
+    /**
+     * @brief Works out where the animation puts the servos at a time into it. See sample_at().
+     * @param t_us The time since the start of the animation in microseconds.
+     * @param[in,out] scalars One scalar per servo ID. On entry, where the servos are when the animation starts.
+     * @param[out] tracks If not nullptr, one ServoTrack per servo ID with the servo's move at t_us.
+     * @return The number of the keyframe playing at t_us, -1 if t_us is past the end.
+     */
+    int _sample(unsigned long t_us, float *scalars, ServoTrack *tracks);
+
+    /**
+     * @brief Reads a line of a file. A line too long for the buffer is cut short and the rest of it is skipped.
+     * @param file The file to read from.
+     * @param[out] line The line, without its newline.
+     * @param size The size of the line buffer in bytes.
+     */
+    static void _read_line(fs::File &file, char *line, size_t size);
+
+    /**
+     * @brief Sets every baked servo to its pulse width in the frame at a time into the animation.
+     * @param t_us The time since the start of the animation in microseconds. Past the end gives the last frame.
+     */
+    void _play_baked_frame(unsigned long t_us);
+
+    uint8_t *_arena; /**< The keyframes and then the index in one block, nullptr until the first keyframe is added. */
+    size_t _arena_bytes; /**< The size of the arena in bytes. */
+    ServoKeyframe *_keyframes; /**< The keyframes in order, at the start of the arena. */
+    int _num_keyframes; /**< The number of keyframes. */
+    int _keyframe_capacity; /**< The number of keyframes the array holds before it has to grow. */
+    int _current_index; /**< The number of the keyframe being played, -1 for none. */
+    unsigned long _timeline_start_us; /**< The micros() time the timeline started at. */
+    unsigned long _keyframe_start_us; /**< The micros() time the current keyframe starts at on the timeline. */
+    unsigned long _carried_us; /**< Total lateness of the keyframe ends since play(). */
+    unsigned long _max_lateness_us; /**< Largest lateness of a keyframe end since play(). */
     bool _playing; /**< Flag indicating if the animation is currently playing. */
-    bool _keyframe_has_started; /**< Flag indicating if the current keyframe has started. */
+    bool _timeline_started; /**< Flag indicating if the timeline has started. */
+
+    // Playback
+    uint32_t _rate_q16; /**< Speed of the timeline clock in Q16, 1.0 is the recorded speed. */
+    bool _reversed; /**< The first pass plays from the end back to the start. */
+    PlaybackMode _mode; /**< What happens at the end of a pass. */
+    unsigned int _passes; /**< The number of passes to play, 0 plays until stopped. */
+    unsigned long _pass; /**< The pass being played, 0 is the first. */
+    unsigned long _clock_us; /**< The micros() time the timeline clock was last advanced. */
+    uint64_t _played_q16; /**< Time played into the current pass at the playback rate, in Q16 microseconds. */
+    unsigned long _duration_us; /**< Length of one pass, worked out when the timeline starts. */
+    bool _discontinuity; /**< The servos were set somewhere other than where the last update left them. */
+    float _pass_start_scalars[ServoContext::MAX_SERVOS]; /**< Where the servos are at the start of the timeline. */
+    ServoTrack _tracks[ServoContext::MAX_SERVOS]; /**< Each servo's move at the last clocked update. */
+    int _tracks_index; /**< The keyframe _tracks have been followed to, -1 to follow them from the start. */
+
+    // Index
+    unsigned long *_index_start_us; /**< Start time of each keyframe, then the end of the animation. After the
+                                       keyframes in the arena. */
+    bool _index_stale; /**< Keyframes were added or removed since the index was built. */
+    bool _seek_pending; /**< The timeline jumps to _seek_us at the next update. */
+    unsigned long _seek_us; /**< The time seek() moved the timeline to. */
+    int _seek_index; /**< The keyframe playing at _seek_us. */
+    bool _start_at_pending; /**< The timeline starts at _start_at_us instead of the first update. */
+    unsigned long _start_at_us; /**< The micros() time start_timeline_at() set. */
+    unsigned long _end_us; /**< The micros() time the timeline ended at. */
+
+    BakedChannel *_baked_channels; /**< One per servo the animation moves, nullptr if not baked. */
+    uint16_t *_baked_frames; /**< _num_baked_frames frames of one value per channel, nullptr if not baked. */
+    int _num_baked_channels; /**< The number of baked channels. */
+    unsigned long _num_baked_frames; /**< The number of baked frames, the last one holds the final pose. */
+    unsigned long _baked_frame_us; /**< The time between baked frames in microseconds. */
 
     static constexpr char* const _SERIALIZED_KEYFRAME_START = "start keyframe"; /**< Serialized keyframe start mark. */
     static constexpr char* const _SERIALIZED_KEYFRAME_END   = "end keyframe"; /**< Serialized keyframe end mark. */
@@ -14,28 +14,28 @@
 ServoAnimationRecorder::ServoAnimationRecorder(Display &display, ServoContext &servo_context)
     : _state(States::ENTRY), _animation(new ServoAnimation()), _display(display),
       _display_start_mode(display.getMode()), _keyframe_num(0), _servos(servo_context),
-      _current_keyframe(new ServoKeyframe(_DEFAULT_KEYFRAME_LENGTH_MS)), _cursor_position(_DEFAULT_CURSOR_POSITION),
-      _servo_player(ServoPlayer::getInstance()), _cycle_animation(nullptr) {
+      _cursor_position(_DEFAULT_CURSOR_POSITION),
+      _servo_player(ServoPlayer::getInstance()), _cycle_animation(nullptr), _previewing(false) {
 
     _display.setMode(Display::Mode::RECORDER);
     _display.recording_panel.setStartPage();
 
     // Add the initial (head) keyframe to this animation
-    _animation->set_head(_current_keyframe);
+    _animation->insert_keyframe(0, _DEFAULT_KEYFRAME_LENGTH_MS);
+    _setKeyframePoseToCurrent();
 }
 
 ServoAnimationRecorder::~ServoAnimationRecorder() {
     _display.setMode(_display_start_mode);
 
+    // Make sure the servo player doesn't play or queue either animation once they are deleted
+    _servo_player.forget(_animation);
+    _servo_player.forget(_cycle_animation);
+
     // Delete the animation (and bound keyframes) if the animation was not taken
     if (_animation != nullptr) {
         delete _animation;
     }
-
-    // Make sure the servo player isn't trying to play the cycle animation
-    if (_servo_player.getCurrentAnimation() == _cycle_animation) {
-        _servo_player.stop();
-    }
     // Delete the cycle animation if it exists
     if (_cycle_animation != nullptr) {
         delete _cycle_animation;
@@ -54,7 +54,9 @@ ServoAnimationRecorder::States ServoAnimationRecorder::inputEvent(Inputs input)
         }
         break;
     case States::RECORDING:
-        if (input == Inputs::DONE) {
+        if (_previewing) {
+            _stopPreview(); // The input only stops the playback, the servos aren't back at the keyframe yet
+        } else if (input == Inputs::DONE) {
             _display.recording_panel.setSavePage();
             _state = States::SAVE;
         } else if (input == Inputs::CANCEL) {
@@ -67,6 +69,7 @@ ServoAnimationRecorder::States ServoAnimationRecorder::inputEvent(Inputs input)
     case States::SAVE:
         if (input == Inputs::DONE) {
             _saveCurrentKeyframeServos();
+            _animation->drop_held_servos(); // Moves that were recorded and then put back
             _display.setMode(_display_start_mode);
             _state = States::DONE;
         } else {
@@ -76,6 +79,7 @@ ServoAnimationRecorder::States ServoAnimationRecorder::inputEvent(Inputs input)
         break;
     case States::CANCEL:
         if (input == Inputs::CANCEL) {
+            _servo_player.forget(_animation);
             delete _animation;
             _animation = nullptr;
             _display.setMode(_display_start_mode);
@@ -100,29 +104,38 @@ ServoAnimation *ServoAnimationRecorder::takeAnimation() {
     }
     ServoAnimation *ret = _animation;
     _animation = nullptr;
-    _current_keyframe = nullptr;
     return ret;
 }
 
 void ServoAnimationRecorder::setAnimation(ServoAnimation *animation) {
     if (_animation != nullptr) {
+        _servo_player.forget(_animation);
         delete _animation;
     }
+    // The copy is edited through its keyframes, which would leave baked frames playing the old motion
     _animation = new ServoAnimation(*animation);
-    _current_keyframe = _animation->get_head();
+    _animation->unbake();
+    if (_animation->get_num_keyframes() == 0) {
+        _animation->insert_keyframe(0, _DEFAULT_KEYFRAME_LENGTH_MS);
+    }
     _keyframe_num = 0;
     _cursor_position = _DEFAULT_CURSOR_POSITION;
     _moveServosToCurrentKeyframe();
 }
 
 void ServoAnimationRecorder::addTrackToKeyframe(int track_index, DfMp3 *dfmp3) {
-    if (_current_keyframe != nullptr) {
-        _current_keyframe->add_track(track_index, dfmp3);
+    ServoKeyframe *keyframe = _currentKeyframe();
+    if (keyframe != nullptr) {
+        keyframe->add_track(track_index, dfmp3);
     }
 }
 
+ServoKeyframe *ServoAnimationRecorder::_currentKeyframe() {
+    return _animation != nullptr ? _animation->get_keyframe(_keyframe_num) : nullptr;
+}
+
 void ServoAnimationRecorder::_updateRecordingStateDisplay() {
-    _display.recording_panel.setRecordingPage(_current_keyframe->get_duration(), _cursor_position, _keyframe_num,
+    _display.recording_panel.setRecordingPage(_currentKeyframe()->get_duration(), _cursor_position, _keyframe_num,
                                               &_servos);
 }
 
@@ -141,6 +154,9 @@ void ServoAnimationRecorder::_handleRecordingInput(Inputs input) {
     case Inputs::PREV:
         _goToPrevKeyframe();
         break;
+    case Inputs::PLAY:
+        _playFromCurrentKeyframe();
+        return;
     case Inputs::DELETE:
         _deleteCurrentKeyframe();
     default:
@@ -154,25 +170,20 @@ void ServoAnimationRecorder::_handleRecordingInput(Inputs input) {
 void ServoAnimationRecorder::_goToNextKeyframe() {
     _saveCurrentKeyframeServos(); // Update the current keyframe's servos in case they were moved
     // If the current keyframe has a next keyframe, move to it. Otherwise, create a new keyframe
-    if (_current_keyframe->get_next() != nullptr) {
-        _current_keyframe = _current_keyframe->get_next();
+    if (_keyframe_num + 1 < _animation->get_num_keyframes()) {
+        _keyframe_num++;
         _moveServosToCurrentKeyframe();
-    } else {
-        // We were already at the tail, so create a new keyframe
-        ServoKeyframe *new_keyframe = new ServoKeyframe(_DEFAULT_KEYFRAME_LENGTH_MS);
-        _current_keyframe->set_next(new_keyframe);
-        new_keyframe->set_prev(_current_keyframe);
-        _current_keyframe = new_keyframe;
+    } else if (_animation->insert_keyframe(_keyframe_num + 1, _DEFAULT_KEYFRAME_LENGTH_MS) != nullptr) {
+        // We were already at the tail, so the new keyframe starts from the pose the servos are in
+        _keyframe_num++;
+        _setKeyframePoseToCurrent();
     }
-    _keyframe_num++;
 }
 
 void ServoAnimationRecorder::_goToPrevKeyframe() {
     _saveCurrentKeyframeServos(); // Update the current keyframe's servos in case they were moved
     // If the current keyframe has a previous keyframe, move to it
-    if (_current_keyframe->get_prev() != nullptr) {
-        // Move to the previous keyframe
-        _current_keyframe = _current_keyframe->get_prev();
+    if (_keyframe_num > 0) {
         _keyframe_num--;
         _moveServosToCurrentKeyframe();
     }
@@ -180,25 +191,15 @@ void ServoAnimationRecorder::_goToPrevKeyframe() {
 
 void ServoAnimationRecorder::_deleteCurrentKeyframe() {
     // Remove the current keyframe from the animtion. Defaults to going to the next keyframe if it exists, otherwise
-    // the previous keyframe
-    ServoKeyframe *to_delete = _current_keyframe;
-
-    // If there is another keyframe after this one, move to it
-    if (_current_keyframe->get_next() != nullptr) {
-        _goToNextKeyframe();
-        _keyframe_num--; // Next keyframe is now the current keyframe, so decrement the keyframe number
-    } else if (_current_keyframe->get_prev() != nullptr) { // If there is another keyframe before this one, move to it
-        _goToPrevKeyframe();
-    } else { // If there are no other keyframes, we're at the head and we can't delete it
+    // the previous keyframe. If there are no other keyframes, we're at the head and we can't delete it.
+    if (_animation->get_num_keyframes() <= 1) {
         return;
     }
-
-    // If we removed the head, set the new head
-    if (to_delete == _animation->get_head()) {
-        _animation->set_head(_current_keyframe);
+    _animation->remove_keyframe(_keyframe_num);
+    if (_keyframe_num >= _animation->get_num_keyframes()) {
+        _keyframe_num--;
     }
-    // Remove the keyframe from the animation
-    delete to_delete; // NOTE: The deconstructor for ServoKeyframe will restitch the list
+    _moveServosToCurrentKeyframe();
     _updateRecordingStateDisplay();
 }
 
@@ -210,21 +211,74 @@ void ServoAnimationRecorder::_moveServosToCurrentKeyframe() {
         _servo_player.stop();
     }
 
+    // The keyframe may only hold a few servos, so move every servo to the whole pose it leaves them in
+    _loadKeyframePose();
+    _moveServosToKeyframePose();
+}
+
+void ServoAnimationRecorder::_playFromCurrentKeyframe() {
+    _saveCurrentKeyframeServos(); // Keep the edits to the current keyframe
+    _loadKeyframePose();          // Where to go back to, with the edits
+    if (!_animation->seek_keyframe(_keyframe_num)) {
+        return;
+    }
+    _servo_player.play(_animation);
+    _previewing = true;
+}
+
+void ServoAnimationRecorder::_stopPreview() {
+    _previewing = false;
+    _moveServosToKeyframePose();
+}
+
+void ServoAnimationRecorder::_moveServosToKeyframePose() {
+    if (_servo_player.isPlaying()) {
+        _servo_player.stop();
+    }
+
     // Delete the current cycle animation if it exists
     if (_cycle_animation != nullptr) {
         delete _cycle_animation;
     }
     _cycle_animation = new ServoAnimation();
-    ServoKeyframe *isolated_keyframe = new ServoKeyframe(*_current_keyframe);
-    isolated_keyframe->set_next(nullptr);
-    isolated_keyframe->set_prev(nullptr);
-    isolated_keyframe->set_duration(_KEYFRAME_CHANGE_DURATION_MS);
-    _cycle_animation->add_keyframe(isolated_keyframe);
+    ServoKeyframe *pose_keyframe = new ServoKeyframe(_KEYFRAME_CHANGE_DURATION_MS);
+    for (int id = 0; id < _servos.get_num_servos(); id++) {
+        ServoMotor *servo = _servos.get(id);
+        if (servo != nullptr) {
+            pose_keyframe->add_servo_scalar(servo, _keyframe_pose[id]);
+        }
+    }
+    _cycle_animation->add_keyframe(pose_keyframe);
     _servo_player.play(_cycle_animation);
 }
 
+void ServoAnimationRecorder::_loadKeyframePose() {
+    _setKeyframePoseToCurrent(); // For servos the animation doesn't move before this keyframe
+
+    _animation->reindex(); // The durations are edited in place
+    _animation->sample_at(_animation->get_keyframe_start_us(_keyframe_num), _keyframe_pose);
+
+    ServoKeyframe *keyframe = _currentKeyframe();
+    for (int id = 0; id < _servos.get_num_servos(); id++) {
+        ServoMotor *servo = _servos.get(id);
+        float       target;
+        ramp_mode   mode;
+        if (servo != nullptr && keyframe->get_servo_target(servo, &target, &mode)) {
+            _keyframe_pose[id] = target;
+        }
+    }
+}
+
+void ServoAnimationRecorder::_setKeyframePoseToCurrent() {
+    for (int id = 0; id < ServoContext::MAX_SERVOS; id++) {
+        ServoMotor *servo = _servos.get(id);
+        _keyframe_pose[id] = servo != nullptr ? servo->get_current_scalar() : 0;
+    }
+}
+
 void ServoAnimationRecorder::_updateKeyframeDuration(Inputs input) {
-    int _new_keyframe_duration_ms = _current_keyframe->get_duration();
+    ServoKeyframe *keyframe = _currentKeyframe();
+    int            _new_keyframe_duration_ms = keyframe->get_duration();
     switch (input) {
     case Inputs::UP:
         _new_keyframe_duration_ms += std::pow(10, _cursor_position);
@@ -244,11 +298,30 @@ void ServoAnimationRecorder::_updateKeyframeDuration(Inputs input) {
     // Constrain the duration to the min and max values
     _new_keyframe_duration_ms =
         constrain(_new_keyframe_duration_ms, _MIN_KEYFRAME_LENGTH_MS, _MAX_KEYFRAME_LENGTH_MS);
-    _current_keyframe->set_duration(_new_keyframe_duration_ms);
+    keyframe->set_duration(_new_keyframe_duration_ms);
 }
 
 void ServoAnimationRecorder::_saveCurrentKeyframeServos() {
-    for (auto &servo : _servos.map) {
-        _current_keyframe->add_servo_scalar(servo.second, servo.second->get_current_scalar());
+    ServoKeyframe *keyframe = _currentKeyframe();
+    bool           is_head = _keyframe_num == 0;
+    for (int id = 0; id < _servos.get_num_servos(); id++) {
+        ServoMotor *servo = _servos.get(id);
+        if (servo == nullptr) {
+            continue;
+        }
+        // Compare pulse widths, the scalars of the same position can differ by a rounding error
+        int           current_us = servo->get_current_us();
+        float         target;
+        ramp_mode     mode;
+        unsigned long duration_ms;
+        if (keyframe->get_servo_target(servo, &target, &mode, &duration_ms)) {
+            // Keep how the servo moves, only the target was edited
+            if (current_us != servo->scalar_to_us(target)) {
+                duration_ms = duration_ms == keyframe->get_duration() ? 0 : duration_ms;
+                keyframe->add_servo_scalar(servo, servo->get_current_scalar(), mode, duration_ms);
+            }
+        } else if (is_head || current_us != servo->scalar_to_us(_keyframe_pose[id])) {
+            keyframe->add_servo_scalar(servo, servo->get_current_scalar());
+        }
     }
 }
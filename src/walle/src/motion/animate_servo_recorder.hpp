@@ -26,6 +26,13 @@
  *
  * This class provides functionality for recording servo animations. It allows the user to control the animation
  * recording process, add keyframes, and save the animation.
+ *
+ * The head keyframe records every servo, so the animation always starts from a known pose. Every other keyframe only
+ * records the servos that were moved away from where the animation already has them, so a recording grows with the
+ * motion in it rather than with the number of joints.
+ *
+ * The PLAY input plays the animation from the current keyframe, so the end of a long routine can be checked without
+ * waiting through the rest of it. Any input after that stops the playback and moves the servos back to the keyframe.
  */
 class ServoAnimationRecorder {
   public:
@@ -41,7 +48,8 @@ class ServoAnimationRecorder {
         UP,        /**< Up input */
         DOWN,      /**< Down input */
         LEFT,      /**< Left input */
-        RIGHT      /**< Right input */
+        RIGHT,     /**< Right input */
+        PLAY       /**< Play from the current keyframe input */
     };
 
     /**
@@ -123,13 +131,20 @@ class ServoAnimationRecorder {
     Display::Mode _display_start_mode;   /**< Start mode of the display tracked so it can be reset on completion */
     ServoAnimation *_animation;          /**< Animation object */
     ServoAnimation *_cycle_animation;    /**< Animation object used for cycling through keyframes */
-    ServoKeyframe* _current_keyframe;    /**< Current keyframe */
     ServoContext& _servos;               /**< Servo context object */
     ServoPlayer& _servo_player;          /**< Servo player object used for moving servos during keyframe changes */
 
-    int _keyframe_num;                   /**< Number of keyframes */
+    float _keyframe_pose[ServoContext::MAX_SERVOS]; /**< Where the current keyframe puts every servo, by servo ID */
+    int _keyframe_num;                   /**< Number of the current keyframe in the animation */
     int _current_keyframe_duration_ms;   /**< Duration of the current keyframe in milliseconds */
     unsigned int _cursor_position;       /**< Current cursor position for keyframe length */
+    bool _previewing;                    /**< The animation is playing from the current keyframe */
+
+    /**
+     * @brief Gets the keyframe being edited.
+     * @return The keyframe, or nullptr once the animation has been taken.
+     */
+    ServoKeyframe *_currentKeyframe();
 
     /**
      * @brief Updates the display during the recording state.
@@ -158,6 +173,32 @@ class ServoAnimationRecorder {
      */
     void _deleteCurrentKeyframe();
 
+    /**
+     * @brief Plays the animation from the current keyframe, keeping the edits made to it.
+     */
+    void _playFromCurrentKeyframe();
+
+    /**
+     * @brief Stops playing the animation and moves the servos back to the current keyframe.
+     */
+    void _stopPreview();
+
+    /**
+     * @brief Moves the servos to _keyframe_pose.
+     */
+    void _moveServosToKeyframePose();
+
+    /**
+     * @brief Works out where the current keyframe puts every servo into _keyframe_pose. A servo the keyframe moves is
+     * at its target, and any other servo is where the animation has it when the keyframe starts.
+     */
+    void _loadKeyframePose();
+
+    /**
+     * @brief Sets _keyframe_pose to where the servos are now, for a keyframe that doesn't move anything yet.
+     */
+    void _setKeyframePoseToCurrent();
+
     /**
      * @brief Moves the servos to the current keyframe.
      */
@@ -171,7 +212,8 @@ class ServoAnimationRecorder {
     void _updateKeyframeDuration(Inputs input);
 
     /**
-     * @brief Saves the servo states of all the servos to the current keyframe.
+     * @brief Saves the servos that were moved away from _keyframe_pose to the current keyframe. The head keyframe saves
+     * every servo.
      */
     void _saveCurrentKeyframeServos();
 };
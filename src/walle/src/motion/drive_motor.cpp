@@ -10,10 +10,11 @@
  */
 #include "drive_motor.hpp"
 
-DriveMotor::DriveMotor(Adafruit_PWMServoDriver *pca9685, int pin, int min_us, int max_us)
-    : _pwm_driver(pca9685), _pin(pin), _min_us(min_us), _max_us(max_us), _neutral_us((max_us + min_us) / 2),
-      _max_speed(1.0), _acceleration_per_ms(_DRIVE_MOTOR_DEFAULT_ACCELERATION),
-      _deceleration_per_ms(_DRIVE_MOTOR_DEFAULT_ACCELERATION), _last_update_ms(0) {}
+DriveMotor::DriveMotor(PwmBoardGroup *pwm_boards, PwmAddress address, int min_us, int max_us)
+    : _pwm_frame(pwm_boards->get_frame(address)), _address(address), _min_us(min_us), _max_us(max_us),
+      _neutral_us((max_us + min_us) / 2), _max_speed(1.0), _acceleration_per_ms(_DRIVE_MOTOR_DEFAULT_ACCELERATION),
+      _deceleration_per_ms(_DRIVE_MOTOR_DEFAULT_ACCELERATION), _last_update_ms(0), _last_written_ticks(-1),
+      _writes_issued(0), _writes_skipped(0) {}
 
 void DriveMotor::set_speed(float speed) {
     // Constrain speed between -1.0 and 1.0
@@ -46,16 +47,24 @@ void DriveMotor::set_deceleration(float deceleration_per_ss) {
 }
 
 float DriveMotor::update() {
-    // Set the pwm_driver's output to the give us
-
-    // NOTE: Adafruit's microseconds function reads the prescaler every time this is called, which is a bit unnessisary.
-    // If there becomes a reason to, we can directly callculate the OCR value (4095 counter) from us and our best guess
-    // at clock rate. Servos don't seem to be too picky
+    // Set the pwm_frame's output to the give us. The frame sends it to the PCA9685 on the next flush.
 
     // If we add more acceleration types, we can add a switch here
     this->_update_speed_constant_accel();
 
-    _pwm_driver->writeMicroseconds(_pin, _speed_to_us(_current_speed));
+    if (_pwm_frame == nullptr) {
+        return this->get_current_speed();
+    }
+
+    // Only touch the frame if the pulse width actually changed
+    uint16_t ticks = _pwm_frame->us_to_ticks(_speed_to_us(_current_speed));
+    if (ticks == _last_written_ticks) {
+        _writes_skipped++;
+    } else {
+        _pwm_frame->set_ticks(_address.channel, ticks);
+        _last_written_ticks = ticks;
+        _writes_issued++;
+    }
     return this->get_current_speed();
 }
 
@@ -63,6 +72,10 @@ float DriveMotor::get_current_speed() { return _current_speed; }
 
 float DriveMotor::get_speed_limit() { return _max_speed; }
 
+unsigned long DriveMotor::get_writes_issued() { return _writes_issued; }
+
+unsigned long DriveMotor::get_writes_skipped() { return _writes_skipped; }
+
 void DriveMotor::_update_speed_constant_accel() {
     // This is a bit tricky because there are multiple cases that have to be handeld differently:
     //
@@ -15,7 +15,7 @@
 #define _DRIVE_MOTOR_S_TO_MS (1000)
 #define _DRIVE_MOTOR_DEFAULT_ACCELERATION (10.0 / _DRIVE_MOTOR_S_TO_MS)
 
-#include <Adafruit_PWMServoDriver.h>
+#include "pwm_board_group.hpp"
 #include <Arduino.h>
 
 
@@ -31,14 +31,14 @@ class DriveMotor {
      *
      * NOTE: Neutral is assumed to be the center of min_us and max_us. Motor is set to neutral on construction. Does not
      * call Adafruit_PWMServoDriver's begin() for you, please begin before using. This is to allow for multiple motors
-     * to be controlled by the same PCA9685.
+     * to be controlled by the same PCA9685. Nothing reaches the PCA9685 until the frame is flushed.
      * 
-     * @param pca9685 Pointer to the Adafruit_PWMServoDriver object used to control the motor.
-     * @param pin The pin number of the motor.
+     * @param pwm_boards Pointer to the PCA9685 boards.
+     * @param address The board and channel the motor is connected to.
      * @param min_us The minimum pulse width in microseconds for the motor.
      * @param max_us The maximum pulse width in microseconds for the motor.
      */
-    DriveMotor(Adafruit_PWMServoDriver *pca9685, int pin, int min_us = 500, int max_us = 2500);
+    DriveMotor(PwmBoardGroup *pwm_boards, PwmAddress address, int min_us = 500, int max_us = 2500);
 
     /**
      * @brief Sets the speed of the motor.
@@ -71,8 +71,8 @@ class DriveMotor {
     void set_deceleration(float deceleration_per_ss);
 
     /**
-     * @brief Updates the motor speed and writes the output to the PWM driver. This method should be called periodically
-     * to update the motor speed.
+     * @brief Updates the motor speed and writes the output to the PWM frame. This method should be called periodically
+     * to update the motor speed. The PWM frame is only written when the pulse width has changed since the last write.
      * 
      * @return The current speed of the motor.
      */
@@ -92,9 +92,23 @@ class DriveMotor {
      */
     float get_speed_limit();
 
+    /**
+     * @brief Gets the number of times update() wrote a new pulse width to the PWM frame.
+     * 
+     * @return The number of writes issued.
+     */
+    unsigned long get_writes_issued();
+
+    /**
+     * @brief Gets the number of times update() skipped the write because the pulse width had not changed.
+     * 
+     * @return The number of writes skipped.
+     */
+    unsigned long get_writes_skipped();
+
   private:
-    Adafruit_PWMServoDriver *_pwm_driver;
-    int                      _pin;
+    PwmFrame                *_pwm_frame;
+    PwmAddress               _address;
     int                      _min_us;
     int                      _max_us;
     int                      _neutral_us;
@@ -104,6 +118,9 @@ class DriveMotor {
     float _current_speed;
     float _target_speed;
     float _max_speed;
+    int           _last_written_ticks; // The last pulse width written to the PWM frame in ticks, -1 if never written
+    unsigned long _writes_issued; // Number of pulse widths written to the PWM frame
+    unsigned long _writes_skipped; // Number of updates that didn't need to write to the PWM frame
 
     /**
      * @brief Calculates the current speed for the constant acceleration type.
@@ -0,0 +1,183 @@
+/**
+ * @file easing.cpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the easing lookup tables, the tables that pick an easing curve at runtime and a benchmark
+ * of the two ways of evaluating a curve.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "easing.hpp"
+#include <Arduino.h>
+
+// Every curve has to start at 0 and end at 1
+static_assert(ease_q16<QUADRATIC_INOUT>(0) == 0 && ease_q16<QUADRATIC_INOUT>(Q16_ONE) == Q16_ONE, "QUADRATIC ends");
+static_assert(ease_q16<SINUSOIDAL_INOUT>(0) == 0 && ease_q16<SINUSOIDAL_INOUT>(Q16_ONE) == Q16_ONE, "SINUSOIDAL ends");
+static_assert(ease_q16<EXPONENTIAL_IN>(Q16_ONE) == Q16_ONE && ease_q16<EXPONENTIAL_OUT>(0) == 0, "EXPONENTIAL ends");
+static_assert(ease_q16<CIRCULAR_INOUT>(0) == 0 && ease_q16<CIRCULAR_INOUT>(Q16_ONE) == Q16_ONE, "CIRCULAR ends");
+static_assert(ease_q16<ELASTIC_INOUT>(0) == 0 && ease_q16<ELASTIC_INOUT>(Q16_ONE) == Q16_ONE, "ELASTIC ends");
+static_assert(ease_q16<BACK_INOUT>(0) == 0 && ease_q16<BACK_INOUT>(Q16_ONE) == Q16_ONE, "BACK ends");
+static_assert(ease_q16<BOUNCE_INOUT>(0) == 0 && ease_q16<BOUNCE_INOUT>(Q16_ONE) == Q16_ONE, "BOUNCE ends");
+static_assert(ease_q16<CATMULL_ROM>(0) == 0 && ease_q16<CATMULL_ROM>(Q16_ONE) == Q16_ONE, "CATMULL_ROM ends");
+static_assert(q16_hermite_h10(Q16_ONE) == 0 && q16_hermite_h11(Q16_ONE) == 0, "Hermite tangents end at 0");
+
+/*----------- Lookup tables -----------------------------------------------------------------------------------------
+ * EaseTable<MODE, ...>::values is filled by expanding a pack of indices 0 to EASE_TABLE_STEPS into one ease_q16() call
+ * each, so the compiler evaluates every entry and the table ends up in flash with the rest of the constants.
+ */
+template <int... I> struct EaseTableIndices {};
+template <int N, int... I> struct MakeEaseTableIndices : MakeEaseTableIndices<N - 1, N - 1, I...> {};
+template <int... I> struct MakeEaseTableIndices<0, I...> {
+    typedef EaseTableIndices<I...> type;
+};
+
+template <ramp_mode MODE, typename INDICES> struct EaseTable;
+template <ramp_mode MODE, int... I> struct EaseTable<MODE, EaseTableIndices<I...>> {
+    static constexpr q16_t values[] = {ease_q16<MODE>(I << EASE_TABLE_SHIFT)...};
+};
+template <ramp_mode MODE, int... I> constexpr q16_t EaseTable<MODE, EaseTableIndices<I...>>::values[];
+
+/**
+ * @brief Evaluates an easing curve from its lookup table, interpolating linearly between the two nearest entries.
+ */
+template <ramp_mode MODE> q16_t ease_table_q16(q16_t t) {
+    typedef EaseTable<MODE, MakeEaseTableIndices<EASE_TABLE_STEPS + 1>::type> Table;
+    if (t <= 0) {
+        return Table::values[0];
+    }
+    if (t >= Q16_ONE) {
+        return Table::values[EASE_TABLE_STEPS];
+    }
+    int   i = t >> EASE_TABLE_SHIFT;
+    q16_t frac = t & ((1 << EASE_TABLE_SHIFT) - 1);
+    return Table::values[i] + (((Table::values[i + 1] - Table::values[i]) * frac) >> EASE_TABLE_SHIFT);
+}
+
+/*----------- Runtime selection -------------------------------------------------------------------------------------*/
+// Both tables are in ramp_mode order. NONE and LINEAR are cheaper to calculate than to look up, and CIRCULAR is too
+// steep next to 0 and 1 for a table.
+static const EaseFunction EASE_FUNCTIONS[] = {
+    ease_q16<NONE>,                    ease_q16<LINEAR>,
+    ease_table_q16<QUADRATIC_IN>,      ease_table_q16<QUADRATIC_OUT>,     ease_table_q16<QUADRATIC_INOUT>,
+    ease_table_q16<CUBIC_IN>,          ease_table_q16<CUBIC_OUT>,         ease_table_q16<CUBIC_INOUT>,
+    ease_table_q16<QUARTIC_IN>,        ease_table_q16<QUARTIC_OUT>,       ease_table_q16<QUARTIC_INOUT>,
+    ease_table_q16<QUINTIC_IN>,        ease_table_q16<QUINTIC_OUT>,       ease_table_q16<QUINTIC_INOUT>,
+    ease_table_q16<SINUSOIDAL_IN>,     ease_table_q16<SINUSOIDAL_OUT>,    ease_table_q16<SINUSOIDAL_INOUT>,
+    ease_table_q16<EXPONENTIAL_IN>,    ease_table_q16<EXPONENTIAL_OUT>,   ease_table_q16<EXPONENTIAL_INOUT>,
+    ease_q16<CIRCULAR_IN>,             ease_q16<CIRCULAR_OUT>,            ease_q16<CIRCULAR_INOUT>,
+    ease_table_q16<ELASTIC_IN>,        ease_table_q16<ELASTIC_OUT>,       ease_table_q16<ELASTIC_INOUT>,
+    ease_table_q16<BACK_IN>,           ease_table_q16<BACK_OUT>,          ease_table_q16<BACK_INOUT>,
+    ease_table_q16<BOUNCE_IN>,         ease_table_q16<BOUNCE_OUT>,        ease_table_q16<BOUNCE_INOUT>,
+    ease_table_q16<CATMULL_ROM>,
+};
+static_assert(sizeof(EASE_FUNCTIONS) / sizeof(EASE_FUNCTIONS[0]) == CATMULL_ROM + 1, "One curve per ramp_mode");
+
+static const EaseFunction EASE_EXACT_FUNCTIONS[] = {
+    ease_q16<NONE>,              ease_q16<LINEAR>,
+    ease_q16<QUADRATIC_IN>,      ease_q16<QUADRATIC_OUT>,     ease_q16<QUADRATIC_INOUT>,
+    ease_q16<CUBIC_IN>,          ease_q16<CUBIC_OUT>,         ease_q16<CUBIC_INOUT>,
+    ease_q16<QUARTIC_IN>,        ease_q16<QUARTIC_OUT>,       ease_q16<QUARTIC_INOUT>,
+    ease_q16<QUINTIC_IN>,        ease_q16<QUINTIC_OUT>,       ease_q16<QUINTIC_INOUT>,
+    ease_q16<SINUSOIDAL_IN>,     ease_q16<SINUSOIDAL_OUT>,    ease_q16<SINUSOIDAL_INOUT>,
+    ease_q16<EXPONENTIAL_IN>,    ease_q16<EXPONENTIAL_OUT>,   ease_q16<EXPONENTIAL_INOUT>,
+    ease_q16<CIRCULAR_IN>,       ease_q16<CIRCULAR_OUT>,      ease_q16<CIRCULAR_INOUT>,
+    ease_q16<ELASTIC_IN>,        ease_q16<ELASTIC_OUT>,       ease_q16<ELASTIC_INOUT>,
+    ease_q16<BACK_IN>,           ease_q16<BACK_OUT>,          ease_q16<BACK_INOUT>,
+    ease_q16<BOUNCE_IN>,         ease_q16<BOUNCE_OUT>,        ease_q16<BOUNCE_INOUT>,
+    ease_q16<CATMULL_ROM>,
+};
+static_assert(sizeof(EASE_EXACT_FUNCTIONS) / sizeof(EASE_EXACT_FUNCTIONS[0]) == CATMULL_ROM + 1,
+              "One curve per ramp_mode");
+
+EaseFunction ease_function(ramp_mode mode) {
+    if (mode < NONE || mode > CATMULL_ROM) {
+        return EASE_FUNCTIONS[LINEAR];
+    }
+    return EASE_FUNCTIONS[mode];
+}
+
+EaseFunction ease_function_exact(ramp_mode mode) {
+    if (mode < NONE || mode > CATMULL_ROM) {
+        return EASE_EXACT_FUNCTIONS[LINEAR];
+    }
+    return EASE_EXACT_FUNCTIONS[mode];
+}
+
+/*----------- Benchmark ---------------------------------------------------------------------------------------------*/
+static const char *EASE_MODE_NAMES[] = {
+    "NONE",
+    "LINEAR",
+    "QUADRATIC_IN",
+    "QUADRATIC_OUT",
+    "QUADRATIC_INOUT",
+    "CUBIC_IN",
+    "CUBIC_OUT",
+    "CUBIC_INOUT",
+    "QUARTIC_IN",
+    "QUARTIC_OUT",
+    "QUARTIC_INOUT",
+    "QUINTIC_IN",
+    "QUINTIC_OUT",
+    "QUINTIC_INOUT",
+    "SINUSOIDAL_IN",
+    "SINUSOIDAL_OUT",
+    "SINUSOIDAL_INOUT",
+    "EXPONENTIAL_IN",
+    "EXPONENTIAL_OUT",
+    "EXPONENTIAL_INOUT",
+    "CIRCULAR_IN",
+    "CIRCULAR_OUT",
+    "CIRCULAR_INOUT",
+    "ELASTIC_IN",
+    "ELASTIC_OUT",
+    "ELASTIC_INOUT",
+    "BACK_IN",
+    "BACK_OUT",
+    "BACK_INOUT",
+    "BOUNCE_IN",
+    "BOUNCE_OUT",
+    "BOUNCE_INOUT",
+    "CATMULL_ROM",
+};
+
+/**
+ * @brief Measures the average CPU cycles of one call to a curve, over progress values spread across the whole ramp.
+ *
+ * @param ease The curve.
+ * @param samples The number of calls to average over.
+ * @return The cycles per call, including the call through the pointer like ServoBank::update_all() makes.
+ */
+static float ease_cycles(EaseFunction ease, int samples) {
+    volatile q16_t sink = 0; // Keeps the calls from being optimized away
+    q16_t          step = Q16_ONE / samples;
+    uint32_t       start = ESP.getCycleCount();
+    for (int i = 0; i < samples; i++) {
+        sink = sink + ease(i * step);
+    }
+    return (float)(ESP.getCycleCount() - start) / samples;
+}
+
+void ease_benchmark() {
+    const int SAMPLES = 4096;
+
+    Serial.println("Easing benchmark, CPU cycles per call:");
+    Serial.println("  mode                 exact     table     max difference");
+    for (int mode = NONE; mode <= CATMULL_ROM; mode++) {
+        EaseFunction exact = ease_function_exact((ramp_mode)mode);
+        EaseFunction table = ease_function((ramp_mode)mode);
+        // Run each once first so the flash cache is warm for both
+        ease_cycles(exact, SAMPLES);
+        ease_cycles(table, SAMPLES);
+        float exact_cycles = ease_cycles(exact, SAMPLES);
+        float table_cycles = ease_cycles(table, SAMPLES);
+
+        q16_t max_difference = 0;
+        for (q16_t t = 0; t <= Q16_ONE; t += 7) {
+            max_difference = max(max_difference, (q16_t)abs(exact(t) - table(t)));
+        }
+        Serial.printf("  %-18s %8.1f  %8.1f  %10.6f\n", EASE_MODE_NAMES[mode], exact_cycles, table_cycles,
+                      (float)max_difference / Q16_ONE);
+    }
+}
@@ -0,0 +1,325 @@
+/**
+ * @file easing.hpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the easing curves used by the servo ramps, evaluated in Q16 fixed point with the curve
+ * chosen at compile time, and the lookup tables the ramps read them from.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef EASING_HPP
+#define EASING_HPP
+
+#include <stdint.h>
+
+/**
+ * @brief The easing curves. The values match the ramp_mode enum of the Ramp library this replaces, so saved animations
+ * that store a mode as a number still load with the same curve.
+ */
+enum ramp_mode {
+    NONE = 0, // Holds the start until the ramp ends, then jumps to the target
+    LINEAR,
+    QUADRATIC_IN,
+    QUADRATIC_OUT,
+    QUADRATIC_INOUT,
+    CUBIC_IN,
+    CUBIC_OUT,
+    CUBIC_INOUT,
+    QUARTIC_IN,
+    QUARTIC_OUT,
+    QUARTIC_INOUT,
+    QUINTIC_IN,
+    QUINTIC_OUT,
+    QUINTIC_INOUT,
+    SINUSOIDAL_IN,
+    SINUSOIDAL_OUT,
+    SINUSOIDAL_INOUT,
+    EXPONENTIAL_IN,
+    EXPONENTIAL_OUT,
+    EXPONENTIAL_INOUT,
+    CIRCULAR_IN,
+    CIRCULAR_OUT,
+    CIRCULAR_INOUT,
+    ELASTIC_IN,
+    ELASTIC_OUT,
+    ELASTIC_INOUT,
+    BACK_IN,
+    BACK_OUT,
+    BACK_INOUT,
+    BOUNCE_IN,
+    BOUNCE_OUT,
+    BOUNCE_INOUT,
+    CATMULL_ROM // Runs through a run of CATMULL_ROM keyframes without stopping at each one, see ServoKeyframe
+};
+
+typedef int32_t q16_t; ///< Signed fixed point number with 16 fractional bits
+
+const q16_t Q16_ONE = 1L << 16;  ///< 1.0 in Q16
+const q16_t Q16_HALF = 1L << 15; ///< 0.5 in Q16
+
+/**
+ * @brief Converts a float to Q16, rounding to the nearest value. Meant for constants.
+ */
+constexpr q16_t q16_from_float(float x) {
+    return (q16_t)(x * Q16_ONE + (x < 0 ? -0.5f : 0.5f));
+}
+
+/**
+ * @brief Multiplies two Q16 numbers.
+ */
+constexpr q16_t q16_mul(q16_t a, q16_t b) {
+    return (q16_t)(((int64_t)a * b) >> 16);
+}
+
+/**
+ * @brief Raises a Q16 number to a whole power.
+ */
+constexpr q16_t q16_pow(q16_t x, int n) {
+    return n == 0 ? Q16_ONE : q16_mul(x, q16_pow(x, n - 1));
+}
+
+/**
+ * @brief One step of the bit by bit integer square root. Each step settles one bit of the result.
+ */
+constexpr uint32_t isqrt_step(uint32_t n, uint32_t root, uint32_t bit) {
+    return bit == 0         ? root
+           : n >= root + bit ? isqrt_step(n - root - bit, (root >> 1) + bit, bit >> 2)
+                             : isqrt_step(n, root >> 1, bit >> 2);
+}
+
+/**
+ * @brief Square root of a Q16 number from 0.0 to 1.0.
+ */
+constexpr q16_t q16_sqrt_unit(q16_t x) {
+    return x <= 0 ? 0 : x >= Q16_ONE ? Q16_ONE : (q16_t)isqrt_step((uint32_t)x << 16, 0, 1UL << 30);
+}
+
+/**
+ * @brief The odd Taylor series of sin(x * pi / 2) up to x^9, with x2 = x * x.
+ */
+constexpr q16_t q16_sin_quarter_series(q16_t x, q16_t x2) {
+    return q16_mul(x, q16_from_float(1.5707963f) -
+                          q16_mul(x2, q16_from_float(0.6459641f) -
+                                          q16_mul(x2, q16_from_float(0.0796926f) -
+                                                          q16_mul(x2, q16_from_float(0.0046818f) -
+                                                                          q16_mul(x2, q16_from_float(0.0001605f))))));
+}
+
+/**
+ * @brief sin(x * pi / 2) for x from 0.0 to 1.0. The error is about one Q16 step, and both ends are exact.
+ */
+constexpr q16_t q16_sin_quarter(q16_t x) {
+    return x <= 0 ? 0 : x >= Q16_ONE ? Q16_ONE : q16_sin_quarter_series(x, q16_mul(x, x));
+}
+
+/**
+ * @brief sin() of an angle in turns, one turn is Q16_ONE. Any angle works, negative ones included.
+ */
+constexpr q16_t q16_sin_turns(q16_t turns) {
+    // Split a quarter turn into 2^16 steps, the two bits above that pick the quadrant
+    return ((turns >> 14) & 3) == 0   ? q16_sin_quarter((turns & 0x3FFF) << 2)
+           : ((turns >> 14) & 3) == 1 ? q16_sin_quarter(Q16_ONE - ((turns & 0x3FFF) << 2))
+           : ((turns >> 14) & 3) == 2 ? -q16_sin_quarter((turns & 0x3FFF) << 2)
+                                      : -q16_sin_quarter(Q16_ONE - ((turns & 0x3FFF) << 2));
+}
+
+/**
+ * @brief 2^x for x from 0.0 to 1.0, from a cubic fit. The coefficients add up to exactly 1.0, so 2^1 is exact.
+ */
+constexpr q16_t q16_exp2_unit(q16_t x) {
+    return Q16_ONE + q16_mul(x, q16_from_float(0.6951786f) +
+                                    q16_mul(x, q16_from_float(0.2261963f) + q16_mul(x, q16_from_float(0.0786251f))));
+}
+
+/**
+ * @brief 2^-y for y >= 0.0. Written as 2^(1 - frac(y)) / 2^(int(y) + 1) so the fit only ever sees 0.0 to 1.0.
+ */
+constexpr q16_t q16_exp2_neg(q16_t y) {
+    return (y >> 16) >= 30 ? 0 : q16_exp2_unit(Q16_ONE - (y & 0xFFFF)) >> ((y >> 16) + 1);
+}
+
+/*----------- The IN curve of each family --------------------------------------------------------------------------
+ * The OUT and INOUT curves are built from these by ease_q16(). The constants follow Robert Penner's equations, which
+ * the Ramp library also used.
+ */
+const q16_t EASE_BACK_S = q16_from_float(1.70158f);                      ///< Overshoot of BACK_IN and BACK_OUT
+const q16_t EASE_BACK_INOUT_S = q16_from_float(1.70158f * 1.525f);       ///< Overshoot of BACK_INOUT
+const q16_t EASE_ELASTIC_PERIOD = q16_from_float(0.3f);                  ///< Period of ELASTIC_IN and ELASTIC_OUT
+const q16_t EASE_ELASTIC_INOUT_PERIOD = q16_from_float(0.3f * 1.5f);     ///< Period of ELASTIC_INOUT
+const q16_t EASE_ELASTIC_FREQUENCY = q16_from_float(1.0f / 0.3f);        ///< 1 / EASE_ELASTIC_PERIOD
+const q16_t EASE_ELASTIC_INOUT_FREQUENCY = q16_from_float(1.0f / 0.45f); ///< 1 / EASE_ELASTIC_INOUT_PERIOD
+
+constexpr q16_t q16_sinusoidal_in(q16_t t) {
+    return Q16_ONE - q16_sin_quarter(Q16_ONE - t);
+}
+
+constexpr q16_t q16_exponential_in(q16_t t) {
+    return t <= 0 ? 0 : q16_exp2_neg(10 * (Q16_ONE - t));
+}
+
+constexpr q16_t q16_circular_in(q16_t t) {
+    return Q16_ONE - q16_sqrt_unit(Q16_ONE - q16_mul(t, t));
+}
+
+constexpr q16_t q16_elastic_in(q16_t t, q16_t period, q16_t frequency) {
+    return t <= 0         ? 0
+           : t >= Q16_ONE ? Q16_ONE
+                          : -q16_mul(q16_exp2_neg(10 * (Q16_ONE - t)),
+                                     q16_sin_turns(q16_mul(t - Q16_ONE - period / 4, frequency)));
+}
+
+constexpr q16_t q16_back_in(q16_t t, q16_t s) {
+    return q16_mul(q16_mul(t, t), q16_mul(s + Q16_ONE, t) - s);
+}
+
+constexpr q16_t q16_bounce_out(q16_t t) {
+    return t >= Q16_ONE ? Q16_ONE
+           : t < q16_from_float(1.0f / 2.75f)
+               ? q16_mul(q16_from_float(7.5625f), q16_mul(t, t))
+           : t < q16_from_float(2.0f / 2.75f)
+               ? q16_mul(q16_from_float(7.5625f), q16_pow(t - q16_from_float(1.5f / 2.75f), 2)) +
+                     q16_from_float(0.75f)
+           : t < q16_from_float(2.5f / 2.75f)
+               ? q16_mul(q16_from_float(7.5625f), q16_pow(t - q16_from_float(2.25f / 2.75f), 2)) +
+                     q16_from_float(0.9375f)
+               : q16_mul(q16_from_float(7.5625f), q16_pow(t - q16_from_float(2.625f / 2.75f), 2)) +
+                     q16_from_float(0.984375f);
+}
+
+constexpr q16_t q16_bounce_in(q16_t t) {
+    return Q16_ONE - q16_bounce_out(Q16_ONE - t);
+}
+
+/**
+ * @brief The Hermite basis function that weights the end point of a cubic Hermite segment, 3t^2 - 2t^3. On its own it
+ * is the segment between two points with no speed at either end.
+ */
+constexpr q16_t q16_hermite_h01(q16_t t) {
+    return q16_mul(q16_pow(t, 2), 3 * Q16_ONE - 2 * t);
+}
+
+/**
+ * @brief The Hermite basis function that weights the tangent at the start of a segment, t - 2t^2 + t^3.
+ */
+constexpr q16_t q16_hermite_h10(q16_t t) {
+    return q16_mul(t, q16_pow(Q16_ONE - t, 2));
+}
+
+/**
+ * @brief The Hermite basis function that weights the tangent at the end of a segment, t^3 - t^2.
+ */
+constexpr q16_t q16_hermite_h11(q16_t t) {
+    return -q16_mul(q16_pow(t, 2), Q16_ONE - t);
+}
+
+/**
+ * @brief Evaluates the IN curve of the family FAMILY_IN belongs to.
+ *
+ * @tparam FAMILY_IN The _IN mode of the family.
+ * @tparam INOUT True if the curve is for the family's INOUT mode, which uses its own back and elastic constants.
+ */
+template <ramp_mode FAMILY_IN, bool INOUT> constexpr q16_t ease_in_q16(q16_t t) {
+    return FAMILY_IN == QUADRATIC_IN     ? q16_pow(t, 2)
+           : FAMILY_IN == CUBIC_IN       ? q16_pow(t, 3)
+           : FAMILY_IN == QUARTIC_IN     ? q16_pow(t, 4)
+           : FAMILY_IN == QUINTIC_IN     ? q16_pow(t, 5)
+           : FAMILY_IN == SINUSOIDAL_IN  ? q16_sinusoidal_in(t)
+           : FAMILY_IN == EXPONENTIAL_IN ? q16_exponential_in(t)
+           : FAMILY_IN == CIRCULAR_IN    ? q16_circular_in(t)
+           : FAMILY_IN == ELASTIC_IN
+               ? (INOUT ? q16_elastic_in(t, EASE_ELASTIC_INOUT_PERIOD, EASE_ELASTIC_INOUT_FREQUENCY)
+                        : q16_elastic_in(t, EASE_ELASTIC_PERIOD, EASE_ELASTIC_FREQUENCY))
+           : FAMILY_IN == BACK_IN ? q16_back_in(t, INOUT ? EASE_BACK_INOUT_S : EASE_BACK_S)
+                                  : q16_bounce_in(t);
+}
+
+/**
+ * @brief Gets the _IN mode of the family a mode belongs to.
+ */
+constexpr ramp_mode ease_family(ramp_mode mode) {
+    return mode < QUADRATIC_IN ? QUADRATIC_IN : (ramp_mode)(QUADRATIC_IN + (mode - QUADRATIC_IN) / 3 * 3);
+}
+
+/**
+ * @brief Evaluates an easing curve.
+ *
+ * The mode is a template parameter, so every test on it is decided by the compiler and each instance is only the
+ * arithmetic of its own curve. Use ease_function() to pick an instance at runtime.
+ *
+ * @tparam MODE The easing curve.
+ * @param t The progress of the ramp in Q16, from 0 to Q16_ONE.
+ * @return The eased progress in Q16. 0 is the start and Q16_ONE the target, BACK and ELASTIC curves overshoot both.
+ * CATMULL_ROM gives the segment with no speed at either end.
+ */
+template <ramp_mode MODE> constexpr q16_t ease_q16(q16_t t) {
+    return MODE == NONE          ? 0
+           : MODE == LINEAR      ? t
+           : MODE == CATMULL_ROM ? q16_hermite_h01(t) // The tangents are added by ServoBank
+           // IN
+           : (MODE - QUADRATIC_IN) % 3 == 0 ? ease_in_q16<ease_family(MODE), false>(t)
+           // OUT is IN mirrored around the middle of the ramp
+           : (MODE - QUADRATIC_IN) % 3 == 1 ? Q16_ONE - ease_in_q16<ease_family(MODE), false>(Q16_ONE - t)
+           // INOUT is IN for the first half and OUT for the second, each squeezed into half the time and travel
+           : t < Q16_HALF ? ease_in_q16<ease_family(MODE), true>(2 * t) / 2
+                          : Q16_ONE - ease_in_q16<ease_family(MODE), true>(2 * (Q16_ONE - t)) / 2;
+}
+
+/**
+ * @brief Works out how fast a ramp's Q16 progress grows, so the progress of every tick is a multiply and a shift.
+ *
+ * @param duration_us The length of the ramp in microseconds, more than 0.
+ * @return The Q16 progress per microsecond, times 2^32.
+ */
+inline uint64_t q16_progress_rate(unsigned long duration_us) {
+    return ((uint64_t)Q16_ONE << 32) / duration_us;
+}
+
+/**
+ * @brief Gets the Q16 progress of a ramp.
+ *
+ * @param elapsed_us The time since the ramp started in microseconds, less than its duration.
+ * @param rate The ramp's q16_progress_rate().
+ * @return The progress from 0 up to, but not including, Q16_ONE.
+ */
+inline q16_t q16_progress(unsigned long elapsed_us, uint64_t rate) {
+    return (q16_t)((elapsed_us * rate) >> 32);
+}
+
+typedef q16_t (*EaseFunction)(q16_t t); ///< An easing curve, either an instance of ease_q16() or its lookup table
+
+const int EASE_TABLE_BITS = 8;                         ///< log2 of the number of steps in each lookup table
+const int EASE_TABLE_STEPS = 1 << EASE_TABLE_BITS;     ///< Steps in each lookup table, it holds one more entry
+const int EASE_TABLE_SHIFT = 16 - EASE_TABLE_BITS;     ///< Bits of Q16 progress between two table entries
+
+/**
+ * @brief Gets the easing curve for a mode chosen at runtime.
+ *
+ * Most curves are read from a table of EASE_TABLE_STEPS + 1 values of ease_q16() that the compiler fills in and stores
+ * in flash, with linear interpolation between entries. That is two loads and a multiply whatever the curve, and stays
+ * within 1e-4 of ease_q16() where the curve is smooth. Within one step of a corner, like the bounces of BOUNCE, it
+ * can be up to 1e-2 off. NONE and LINEAR are cheaper to calculate, and CIRCULAR is too steep at its ends to
+ * interpolate, so those three families use ease_q16().
+ *
+ * @param mode The easing curve.
+ * @return The curve's function. Unknown modes get LINEAR.
+ */
+EaseFunction ease_function(ramp_mode mode);
+
+/**
+ * @brief Gets the instance of ease_q16() for a mode chosen at runtime, evaluated without the lookup table.
+ *
+ * @param mode The easing curve.
+ * @return The curve's function. Unknown modes get LINEAR.
+ */
+EaseFunction ease_function_exact(ramp_mode mode);
+
+/**
+ * @brief Times every curve evaluated by ease_q16() against its lookup table and prints the results to Serial.
+ *
+ * Takes a few hundred milliseconds, so only call it from setup().
+ */
+void ease_benchmark();
+
+#endif // EASING_HPP
@@ -0,0 +1,94 @@
+/**
+ * @file motion_task.cpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the implementation of the MotionTask class, which runs the motion update in its own
+ * FreeRTOS task at a fixed rate.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "motion_task.hpp"
+
+MotionTask::MotionTask(TickFunction tick, unsigned long period_us)
+    : _tick(tick), _period_us(period_us), _task_handle(nullptr), _jitter_stats(Stats(0.99)), _jitter_average_us(0),
+      _jitter_max_us(0), _tick_max_us(0), _overruns(0) {
+}
+
+bool MotionTask::begin(int core, unsigned int priority, uint32_t stack_size) {
+    if (_task_handle != nullptr) {
+        return true;
+    }
+    BaseType_t result = xTaskCreatePinnedToCore(&MotionTask::_task_entry, "motion", stack_size, this, priority,
+                                                &_task_handle, core);
+    if (result != pdPASS) {
+        _task_handle = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool MotionTask::isRunning() {
+    return _task_handle != nullptr;
+}
+
+uint32_t MotionTask::get_jitter_average_us() {
+    return _jitter_average_us;
+}
+
+uint32_t MotionTask::get_jitter_max_us() {
+    return _jitter_max_us;
+}
+
+uint32_t MotionTask::get_tick_max_us() {
+    return _tick_max_us;
+}
+
+uint32_t MotionTask::get_overruns() {
+    return _overruns;
+}
+
+void MotionTask::_task_entry(void *arg) {
+    static_cast<MotionTask *>(arg)->_run();
+}
+
+void MotionTask::_run() {
+    const TickType_t period_ticks = max((TickType_t)1, (TickType_t)pdMS_TO_TICKS(_period_us / 1000));
+    const unsigned long period_us = period_ticks * portTICK_PERIOD_MS * 1000UL;
+
+    TickType_t    last_wake = xTaskGetTickCount();
+    unsigned long expected_wake_us = 0;
+    int           skip_ticks = _JITTER_SKIP_TICKS;
+    while (true) {
+        unsigned long wake_us = micros();
+        // Wrap safe: a wake up before the expected time shows up as a huge unsigned value, so clamp those to 0
+        unsigned long late_us = wake_us - expected_wake_us;
+        if ((long)late_us < 0) {
+            late_us = 0;
+        }
+        if (skip_ticks > 0) {
+            // Line the expected time up with a real tick boundary wake up
+            expected_wake_us = wake_us;
+            skip_ticks--;
+        } else {
+            _jitter_stats.addNumber(late_us);
+            _jitter_average_us = (uint32_t)_jitter_stats.average();
+            _jitter_max_us = (uint32_t)_jitter_stats.max();
+        }
+
+        _tick();
+
+        unsigned long tick_us = micros() - wake_us;
+        if (tick_us > _tick_max_us) {
+            _tick_max_us = tick_us;
+        }
+        if (tick_us > period_us) {
+            _overruns++;
+        }
+
+        // Sleep until one period after the last scheduled wake up, not after now, so the rate never drifts
+        expected_wake_us += period_us;
+        vTaskDelayUntil(&last_wake, period_ticks);
+    }
+}
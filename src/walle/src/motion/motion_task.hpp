@@ -0,0 +1,114 @@
+/**
+ * @file motion_task.hpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the declaration of the MotionTask class, which runs the motion update in its own FreeRTOS
+ * task at a fixed rate.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef MOTION_TASK_HPP
+#define MOTION_TASK_HPP
+
+#include <Arduino.h>
+#include "../stats/stats.hpp"
+
+/**
+ * @brief Calls a tick function at a fixed period from a FreeRTOS task pinned to one core.
+ *
+ * The task sleeps with vTaskDelayUntil(), so the period does not drift with how long each tick takes. Every wake up is
+ * timestamped and compared against when it was scheduled, which is reported as the jitter of the task. A tick that
+ * runs past the next wake up is counted as an overrun.
+ *
+ * Everything the tick function touches is owned by the task once begin() is called. Other tasks should hand data to it
+ * through something like a TripleBuffer rather than calling into the same objects.
+ */
+class MotionTask {
+  public:
+    typedef void (*TickFunction)(); ///< The function called once per period
+
+    /**
+     * @brief Constructs a MotionTask object. The task is not started until begin() is called.
+     *
+     * @param tick The function to call every period.
+     * @param period_us The period in microseconds. Rounded down to a whole number of FreeRTOS ticks.
+     */
+    MotionTask(TickFunction tick, unsigned long period_us);
+
+    /**
+     * @brief Creates the task and starts calling the tick function.
+     *
+     * @param core The core to pin the task to.
+     * @param priority The FreeRTOS priority of the task. Should be above loop() (1) so it preempts it.
+     * @param stack_size The stack size of the task in bytes.
+     * @return True if the task was created, false otherwise.
+     */
+    bool begin(int core, unsigned int priority, uint32_t stack_size);
+
+    /**
+     * @brief Checks if the task has been started.
+     *
+     * @return True if the task is running, false otherwise.
+     */
+    bool isRunning();
+
+    /**
+     * @brief Gets the average lateness of the wake up time, in microseconds.
+     *
+     * @return The average jitter in microseconds.
+     */
+    uint32_t get_jitter_average_us();
+
+    /**
+     * @brief Gets the largest lateness of the wake up time seen so far, in microseconds.
+     *
+     * @return The maximum jitter in microseconds.
+     */
+    uint32_t get_jitter_max_us();
+
+    /**
+     * @brief Gets the longest time a single tick took to run, in microseconds.
+     *
+     * @return The maximum tick run time in microseconds.
+     */
+    uint32_t get_tick_max_us();
+
+    /**
+     * @brief Gets the number of ticks that ran longer than the period.
+     *
+     * @return The number of overruns.
+     */
+    uint32_t get_overruns();
+
+  private:
+    // The first wake ups line the expected wake time up with the tick interrupt and aren't counted as jitter
+    static const int _JITTER_SKIP_TICKS = 2;
+
+    TickFunction  _tick;            /**< The function called once per period. */
+    unsigned long _period_us;       /**< The period in microseconds. */
+    TaskHandle_t  _task_handle;     /**< Handle of the FreeRTOS task, nullptr until begin(). */
+    Stats         _jitter_stats;    /**< Wake up lateness in microseconds. Only touched by the task. */
+
+    // Snapshots of the stats for other tasks to read. 32 bit reads and writes are atomic on the ESP32, the doubles in
+    // _jitter_stats are not.
+    volatile uint32_t _jitter_average_us; /**< Average wake up lateness in microseconds. */
+    volatile uint32_t _jitter_max_us;     /**< Maximum wake up lateness in microseconds. */
+    volatile uint32_t _tick_max_us;       /**< Maximum tick run time in microseconds. */
+    volatile uint32_t _overruns;          /**< Number of ticks that ran longer than the period. */
+
+    /**
+     * @brief Entry point of the FreeRTOS task.
+     *
+     * @param arg Pointer to the MotionTask object.
+     */
+    static void _task_entry(void *arg);
+
+    /**
+     * @brief The body of the task. Never returns.
+     */
+    void _run();
+};
+
+#endif // MOTION_TASK_HPP
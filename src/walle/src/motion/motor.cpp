@@ -11,8 +11,9 @@
  */
 #include "motor.hpp"
 
-Motor::Motor(Adafruit_PWMServoDriver *pca9685, int pin, std::string name, int neutral_us, int min_us, int max_us)
-    : _pwm_driver(pca9685), _pin(pin), _neutral_us(neutral_us), _min_us(min_us), _max_us(max_us), _name(name) {
+Motor::Motor(PwmBoardGroup *pwm_boards, PwmAddress address, std::string name, int neutral_us, int min_us, int max_us)
+    : _pwm_frame(pwm_boards->get_frame(address)), _address(address), _neutral_us(neutral_us), _min_us(min_us),
+      _max_us(max_us), _name(name) {
     // Calculate the slope and intercept for the scalar to us mapping
     _scalar_plus_to_us_slope = (float)(_max_us - _neutral_us) / 1.0f;
     _scalar_minus_to_us_slope = (float)(_neutral_us - _min_us) / 1.0f;
@@ -20,15 +21,30 @@ Motor::Motor(Adafruit_PWMServoDriver *pca9685, int pin, std::string name, int ne
     // Set the motor to neutral
     _current_us = _neutral_us;
     _last_update_ms = 0;
+
+    // Nothing has been written yet, so the first update always goes out
+    _last_written_ticks = -1;
+    _writes_issued = 0;
+    _writes_skipped = 0;
 }
 
 void Motor::update() {
-    // write _current_us to _pin
+    if (_pwm_frame == nullptr) {
+        return;
+    }
 
-    // NOTE: Adafruit's microseconds function reads the prescaler every time this is called, which is a bit unnecessary.
-    // If there becomes a reason to, we can directly callculate the OCR value (4095 counter) from us and our best guess
-    // at clock rate. Servos don't seem to be too picky.
-    _pwm_driver->writeMicroseconds(_pin, _current_us);
+    // Convert to ticks with the frame's integer conversion. Skip the frame write if the PCA9685 is already outputting
+    // this pulse width; neighbouring us values often land on the same tick.
+    uint16_t ticks = _pwm_frame->us_to_ticks(_current_us);
+    if (ticks == _last_written_ticks) {
+        _writes_skipped++;
+        return;
+    }
+
+    // write _current_us to the motor's channel. The frame sends it to the PCA9685 on the next flush.
+    _pwm_frame->set_ticks(_address.channel, ticks);
+    _last_written_ticks = ticks;
+    _writes_issued++;
 }
 
 void Motor::set_us(int us) {
@@ -71,6 +87,18 @@ std::string Motor::get_name() {
     return _name;
 }
 
+PwmAddress Motor::get_address() {
+    return _address;
+}
+
+unsigned long Motor::get_writes_issued() {
+    return _writes_issued;
+}
+
+unsigned long Motor::get_writes_skipped() {
+    return _writes_skipped;
+}
+
 int Motor::_scalar_to_us(float scalar) {
     // Return the closest us to the given scalar, account for asymetric mapping of _min_us and _max_us.
     if (scalar > 0) {
@@ -14,11 +14,12 @@
 #ifndef MOTOR_HPP
 #define MOTOR_HPP
 
-#include <Adafruit_PWMServoDriver.h>
+#include "pwm_board_group.hpp"
 #include <Arduino.h>
 
 /**
- * @brief Represents a motor controlled by a PCA9685 PWM servo driver.
+ * @brief Represents a motor controlled by a PCA9685 PWM servo driver. Output is written into a PwmFrame, which is
+ * flushed to the PCA9685 once per control tick.
  */
 class Motor {
   public:
@@ -27,20 +28,21 @@ class Motor {
      *
      * NOTE: Motor is set to neutral on construction (but won't be updated until update() is called). Does not call
      * Adafruit_PWMServoDriver's begin() for you, please begin before using. This is to allow for multiple motors to be
-     * controlled by the same PCA9685.
+     * controlled by the same PCA9685. Nothing reaches the PCA9685 until the frame is flushed.
      *
-     * @param pca9685 Pointer to the PCA9685 PWM servo driver.
-     * @param pin The pin number of the motor.
+     * @param pwm_boards Pointer to the PCA9685 boards.
+     * @param address The board and channel the motor is connected to.
      * @param name The name of the motor.
      * @param neutral_us The neutral position's pulse width in microseconds (default: 1500).
      * @param min_us The minimum pulse width in microseconds (default: 500).
      * @param max_us The maximum pulse width in microseconds (default: 2500).
      */
-    Motor(Adafruit_PWMServoDriver *pca9685, int pin, std::string name, int neutral_us = 1500, int min_us = 500,
+    Motor(PwmBoardGroup *pwm_boards, PwmAddress address, std::string name, int neutral_us = 1500, int min_us = 500,
           int max_us = 2500);
 
     /**
-     * @brief Updates the motor's position based on the current pulse width.
+     * @brief Updates the motor's position based on the current pulse width. The PWM frame is only written when the
+     * pulse width differs from the last value sent to it.
      */
     virtual void update();
 
@@ -102,15 +104,39 @@ class Motor {
      */
     std::string get_name();
 
+    /**
+     * @brief Gets the board and channel the motor is connected to.
+     * 
+     * @return The address of the motor's output.
+     */
+    PwmAddress get_address();
+
+    /**
+     * @brief Gets the number of times update() wrote a new pulse width to the PWM frame.
+     * 
+     * @return The number of writes issued.
+     */
+    unsigned long get_writes_issued();
+
+    /**
+     * @brief Gets the number of times update() skipped the write because the pulse width had not changed.
+     * 
+     * @return The number of writes skipped.
+     */
+    unsigned long get_writes_skipped();
+
   protected:
-    Adafruit_PWMServoDriver *_pwm_driver; // Pointer to the PCA9685 PWM servo driver
-    int                      _pin; // The pin number of the motor
+    PwmFrame                *_pwm_frame; // PWM frame of the motor's board, nullptr if the address is invalid
+    PwmAddress               _address; // The board and channel of the motor
     int                      _min_us; // The minimum pulse width in microseconds
     int                      _max_us; // The maximum pulse width in microseconds
     int                      _neutral_us; // The neutral pulse width in microseconds
     float         _scalar_plus_to_us_slope; // Slope for converting speed scalar to pulse width (positive range)
     float         _scalar_minus_to_us_slope; // Slope for converting speed scalar to pulse width (negative range)
     int           _current_us; // The current pulse width in microseconds
+    int           _last_written_ticks; // The last pulse width written to the PWM frame in ticks, -1 if never written
+    unsigned long _writes_issued; // Number of pulse widths written to the PWM frame
+    unsigned long _writes_skipped; // Number of updates that didn't need to write to the PWM frame
     unsigned long _last_update_ms; // The timestamp of the last update
     std::string   _name; // The name of the motor
 
@@ -0,0 +1,60 @@
+/**
+ * @file output_scheduler.cpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the implementation of the OutputScheduler class, which decides when the PWM outputs are
+ * written so each channel is sent once per PCA9685 PWM period.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "output_scheduler.hpp"
+
+OutputScheduler::OutputScheduler(unsigned long period_us, unsigned long lead_us)
+    : _started(false), _period_us(period_us), _lead_us(min(lead_us, period_us)), _next_due_us(0), _outputs(0),
+      _late_outputs(0) {
+}
+
+void OutputScheduler::begin(unsigned long period_start_us) {
+    _next_due_us = period_start_us + _period_us - _lead_us;
+    _started = true;
+}
+
+void OutputScheduler::set_period_us(unsigned long period_us) {
+    _period_us = period_us;
+    _lead_us = min(_lead_us, _period_us);
+}
+
+bool OutputScheduler::is_due(unsigned long now_us) {
+    if (!_started) {
+        // Nothing to line up with yet, so write every time and anchor on this write
+        begin(now_us);
+        _outputs++;
+        return true;
+    }
+
+    // Wrap safe comparisons, micros() rolls over every ~71 minutes
+    long since_due_us = (long)(now_us - _next_due_us);
+    if (since_due_us < 0) {
+        return false;
+    }
+    if ((unsigned long)since_due_us > _lead_us) {
+        _late_outputs++;
+    }
+
+    // Move on to the first period whose due time is still ahead, skipping any the control tick missed entirely
+    do {
+        _next_due_us += _period_us;
+    } while ((long)(now_us - _next_due_us) >= 0);
+    _outputs++;
+    return true;
+}
+
+unsigned long OutputScheduler::get_outputs() {
+    return _outputs;
+}
+
+unsigned long OutputScheduler::get_late_outputs() {
+    return _late_outputs;
+}
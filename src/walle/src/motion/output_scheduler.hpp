@@ -0,0 +1,90 @@
+/**
+ * @file output_scheduler.hpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the declaration of the OutputScheduler class, which decides when the PWM outputs are
+ * written so each channel is sent once per PCA9685 PWM period.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef OUTPUT_SCHEDULER_HPP
+#define OUTPUT_SCHEDULER_HPP
+
+#include <Arduino.h>
+
+/**
+ * @brief Paces PWM output to once per PWM period while the control logic runs faster.
+ *
+ * A servo only samples its pulse width once per PWM period, so any write before the next period starts is replaced by
+ * the last one. The control tick calls is_due() and flushes the PwmFrame only when it returns true, which is at most
+ * once per period. The frame always holds the newest value of each channel, so nothing is lost by skipping the other
+ * ticks.
+ *
+ * The scheduler keeps an estimate of when each PWM period starts, anchored with begin() and advanced by the period
+ * derived from the PCA9685 prescaler. Output is due lead_us before each estimated start. With a lead of at least one
+ * control tick plus the time a write takes, every period gets exactly one write that lands just before the period
+ * starts, so a servo never sees its pulse change halfway through and picks up the newest value with the least delay.
+ *
+ * NOTE: The estimate drifts by however far the PCA9685 oscillator is from PCA9685_OSCILLATION_FREQ, so calibrate that
+ * value for the board when aligning output to the period.
+ */
+class OutputScheduler {
+  public:
+    /**
+     * @brief Constructs an OutputScheduler object. Output is always due until begin() is called.
+     *
+     * @param period_us The PWM period in microseconds.
+     * @param lead_us How long before the estimated start of a period the output is due, in microseconds.
+     */
+    OutputScheduler(unsigned long period_us, unsigned long lead_us = 0);
+
+    /**
+     * @brief Anchors the schedule to a known PWM period start.
+     *
+     * @param period_start_us The micros() time a PWM period started, e.g. when the PCA9685 came out of sleep.
+     */
+    void begin(unsigned long period_start_us);
+
+    /**
+     * @brief Sets the PWM period. Takes effect from the next due time.
+     *
+     * @param period_us The PWM period in microseconds.
+     */
+    void set_period_us(unsigned long period_us);
+
+    /**
+     * @brief Checks if the output for the next PWM period is due. Returns true at most once per period; when it does
+     * the caller must write the outputs.
+     *
+     * @param now_us The current micros() time.
+     * @return True if the outputs should be written now, false otherwise.
+     */
+    bool is_due(unsigned long now_us);
+
+    /**
+     * @brief Gets the number of times output was due.
+     *
+     * @return The number of outputs.
+     */
+    unsigned long get_outputs();
+
+    /**
+     * @brief Gets the number of outputs that were due after their period had already started, e.g. because the
+     * control tick was late or the lead is shorter than a control tick.
+     *
+     * @return The number of late outputs.
+     */
+    unsigned long get_late_outputs();
+
+  private:
+    bool          _started;      /**< True once begin() has anchored the schedule. */
+    unsigned long _period_us;    /**< The PWM period in microseconds. */
+    unsigned long _lead_us;      /**< How long before a period start the output is due. */
+    unsigned long _next_due_us;  /**< The micros() time the next output is due. */
+    unsigned long _outputs;      /**< Number of outputs. */
+    unsigned long _late_outputs; /**< Number of outputs due after their period started. */
+};
+
+#endif // OUTPUT_SCHEDULER_HPP
@@ -0,0 +1,31 @@
+/**
+ * @file pwm_address.hpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the PwmAddress struct, which addresses one PWM output across several PCA9685 boards.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef PWM_ADDRESS_HPP
+#define PWM_ADDRESS_HPP
+
+#include <stdint.h>
+
+/**
+ * @brief The address of a PWM output: which board it is on and which channel of that board.
+ */
+struct PwmAddress {
+    uint8_t board;   ///< Index of the board in the PwmBoardGroup, not its I2C address
+    uint8_t channel; ///< Channel on the board (0-15), as printed on the silkscreen
+
+    bool operator==(const PwmAddress &other) const {
+        return board == other.board && channel == other.channel;
+    }
+    bool operator!=(const PwmAddress &other) const {
+        return !(*this == other);
+    }
+};
+
+#endif // PWM_ADDRESS_HPP
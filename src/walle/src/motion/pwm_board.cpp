@@ -0,0 +1,149 @@
+/**
+ * @file pwm_board.cpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the implementation of the PwmBoard class, which configures a PCA9685, writes its PwmFrame,
+ * and re-attaches it after I2C faults.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "pwm_board.hpp"
+
+PwmBoard::PwmBoard(PwmBus &bus, uint8_t i2c_addr)
+    : _bus(bus), _i2c_addr(i2c_addr), _frame(i2c_addr, bus.get_wire()), _scheduler(OutputScheduler(0)),
+      _align_output(false), _attached(false), _attaches(0), _faults(0), _fault_start_us(0), _last_downtime_us(0),
+      _last_health_check_ms(0), _next_attempt_ms(0), _retry_backoff_ms(_RETRY_BACKOFF_MIN_MS),
+      _bus_clear_requested(false) {
+}
+
+bool PwmBoard::begin(uint32_t oscillator_freq, float freq, unsigned long output_lead_us) {
+    _frame.set_pwm_freq(oscillator_freq, freq);
+    _scheduler = OutputScheduler(_frame.get_period_us(), output_lead_us);
+    _align_output = output_lead_us > 0;
+    _attached = _attach();
+    if (!_attached) {
+        _fault_start_us = micros();
+        _next_attempt_ms = millis() + _retry_backoff_ms;
+    }
+    return _attached;
+}
+
+bool PwmBoard::update(unsigned long now_us) {
+    // Writes before the next PWM period starts would just replace each other, so only send the newest values once
+    if (!_scheduler.is_due(now_us)) {
+        return _attached;
+    }
+
+    if (_attached) {
+        if (!_frame.flush()) {
+            _detach();
+        } else if (millis() - _last_health_check_ms >= _HEALTH_CHECK_INTERVAL_MS) {
+            _last_health_check_ms = millis();
+            if (!_check_health()) {
+                _detach();
+            }
+        }
+    }
+    if (!_attached && (long)(millis() - _next_attempt_ms) >= 0) {
+        _try_reattach();
+    }
+    return _attached;
+}
+
+PwmFrame &PwmBoard::get_frame() {
+    return _frame;
+}
+
+bool PwmBoard::is_attached() {
+    return _attached;
+}
+
+unsigned long PwmBoard::get_attaches() {
+    return _attaches;
+}
+
+OutputScheduler &PwmBoard::get_scheduler() {
+    return _scheduler;
+}
+
+unsigned long PwmBoard::get_faults() {
+    return _faults;
+}
+
+unsigned long PwmBoard::get_last_downtime_us() {
+    return _last_downtime_us;
+}
+
+bool PwmBoard::take_bus_clear_request() {
+    bool requested = _bus_clear_requested;
+    _bus_clear_requested = false;
+    return requested;
+}
+
+bool PwmBoard::_attach() {
+    if (!_bus.probe(_i2c_addr)) {
+        return false;
+    }
+
+    // Same sequence as Adafruit_PWMServoDriver::setPWMFreq(): the prescaler can only be written while asleep
+    bool success = _bus.write_register(_i2c_addr, PCA9685_MODE1, MODE1_SLEEP | MODE1_AI | MODE1_ALLCAL);
+    success = success && _bus.write_register(_i2c_addr, PCA9685_PRESCALE, _frame.get_prescale());
+    // Waking up restarts the PWM counter, which starts a new period
+    unsigned long period_start_us = micros();
+    success = success && _bus.write_register(_i2c_addr, PCA9685_MODE1, MODE1_AI | MODE1_ALLCAL);
+    if (!success) {
+        return false;
+    }
+    delayMicroseconds(_OSCILLATOR_STARTUP_US);
+    if (!_bus.write_register(_i2c_addr, PCA9685_MODE1, MODE1_RESTART | MODE1_AI | MODE1_ALLCAL)) {
+        return false;
+    }
+
+    // A reset or power cycle leaves every channel off, so resend all of them, not only the ones that changed
+    _frame.invalidate();
+    if (!_frame.flush()) {
+        return false;
+    }
+    _attaches++;
+    if (_align_output) {
+        _scheduler.begin(period_start_us);
+    }
+    _last_health_check_ms = millis();
+    return true;
+}
+
+bool PwmBoard::_check_health() {
+    uint8_t mode1;
+    if (!_bus.read_register(_i2c_addr, PCA9685_MODE1, &mode1)) {
+        return false;
+    }
+    // After a power-on reset the PCA9685 comes back asleep with auto-increment off
+    return !(mode1 & MODE1_SLEEP) && (mode1 & MODE1_AI);
+}
+
+void PwmBoard::_detach() {
+    _attached = false;
+    _faults++;
+    _fault_start_us = micros();
+    // Most faults are a glitch on the bus, so try to come back right away
+    _next_attempt_ms = millis();
+    _retry_backoff_ms = _RETRY_BACKOFF_MIN_MS;
+}
+
+void PwmBoard::_try_reattach() {
+    // Only a stuck bus needs clearing, and that is left to the group since it affects every board on the bus
+    if (_bus.is_sda_low()) {
+        _bus_clear_requested = true;
+    } else if (_attach()) {
+        _attached = true;
+        _last_downtime_us = micros() - _fault_start_us;
+        _retry_backoff_ms = _RETRY_BACKOFF_MIN_MS;
+        return;
+    } else if (_bus.had_bus_error()) {
+        _bus_clear_requested = true;
+    }
+    _next_attempt_ms = millis() + _retry_backoff_ms;
+    _retry_backoff_ms = min(_retry_backoff_ms * 2, (unsigned long)_RETRY_BACKOFF_MAX_MS);
+}
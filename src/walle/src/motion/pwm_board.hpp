@@ -0,0 +1,166 @@
+/**
+ * @file pwm_board.hpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the declaration of the PwmBoard class, which configures a PCA9685, writes its PwmFrame,
+ * and re-attaches it after I2C faults.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef PWM_BOARD_HPP
+#define PWM_BOARD_HPP
+
+#include <Adafruit_PWMServoDriver.h>
+#include <Arduino.h>
+#include "output_scheduler.hpp"
+#include "pwm_bus.hpp"
+#include "pwm_frame.hpp"
+
+/**
+ * @brief A PCA9685 board and the PwmFrame holding its outputs.
+ *
+ * update() flushes the frame once per PWM period, paced by the board's own OutputScheduler. Every board restarts its
+ * PWM counter when it is attached, so each one keeps its own schedule lined up with its own periods.
+ *
+ * update() also watches for faults. A failed write, or a MODE1 register that no longer matches the
+ * configuration (the board browned out and came back asleep with its outputs off), marks the board detached. While
+ * detached the board is re-attached by probing the address, configuring the PCA9685 again and rewriting every
+ * channel. The first attempt is made straight away, so a transient fault costs a few milliseconds. Attempts that fail
+ * back off exponentially so a missing board doesn't keep tying up the bus.
+ *
+ * A board doesn't clear the bus itself, since that tears the bus down under every other board on it. If SDA is held
+ * low or an attempt fails with a bus error it asks for a clear, which its PwmBoardGroup runs for the whole bus. A
+ * missing board only NACKs, so it never asks.
+ *
+ * The PCA9685 is configured directly through its registers rather than through Adafruit_PWMServoDriver, whose begin()
+ * and setPWMFreq() wait ~20 ms in delays that would stall the motion task during a re-attach.
+ */
+class PwmBoard {
+  public:
+    /**
+     * @brief Constructs a PwmBoard object. Nothing is sent to the board until begin() is called.
+     *
+     * @param bus The I2C bus the board is on.
+     * @param i2c_addr The I2C address of the board.
+     */
+    PwmBoard(PwmBus &bus, uint8_t i2c_addr = PCA9685_I2C_ADDRESS);
+
+    /**
+     * @brief Sets the PWM frequency and attaches the board. If the board doesn't respond, update() keeps trying.
+     *
+     * @param oscillator_freq The oscillator frequency of the PCA9685 in Hz.
+     * @param freq The PWM frequency in Hz.
+     * @param output_lead_us How long before each PWM period starts the frame is written. 0 writes once per period
+     * without lining up with the PCA9685's periods.
+     * @return True if the board was attached, false otherwise.
+     */
+    bool begin(uint32_t oscillator_freq, float freq, unsigned long output_lead_us = 0);
+
+    /**
+     * @brief If output is due, writes the frame to the board, checks its health, and re-attaches it if it is detached.
+     * Must be called from the task that owns the bus.
+     *
+     * @param now_us The current micros() time.
+     * @return True if the board is attached, false otherwise.
+     */
+    bool update(unsigned long now_us);
+
+    /**
+     * @brief Gets the frame holding the outputs of this board.
+     *
+     * @return The frame of this board.
+     */
+    PwmFrame &get_frame();
+
+    /**
+     * @brief Checks if the board is attached.
+     *
+     * @return True if the board is attached, false otherwise.
+     */
+    bool is_attached();
+
+    /**
+     * @brief Gets the number of times the board was attached, including the first time. Increments whenever the PWM
+     * counter was restarted.
+     *
+     * @return The number of attaches.
+     */
+    unsigned long get_attaches();
+
+    /**
+     * @brief Gets the output schedule of the board.
+     *
+     * @return The output scheduler.
+     */
+    OutputScheduler &get_scheduler();
+
+    /**
+     * @brief Gets the number of faults detected.
+     *
+     * @return The number of faults.
+     */
+    unsigned long get_faults();
+
+    /**
+     * @brief Gets how long the board was detached the last time it came back, in microseconds.
+     *
+     * @return The last downtime in microseconds.
+     */
+    unsigned long get_last_downtime_us();
+
+    /**
+     * @brief Checks if the board found the bus stuck since the last call, and clears the request.
+     *
+     * @return True if the bus needs clearing.
+     */
+    bool take_bus_clear_request();
+
+  private:
+    static const unsigned long _HEALTH_CHECK_INTERVAL_MS = 500;
+    static const unsigned long _RETRY_BACKOFF_MIN_MS = 10;
+    static const unsigned long _RETRY_BACKOFF_MAX_MS = 2000;
+    static const unsigned int  _OSCILLATOR_STARTUP_US = 500; // From the PCA9685 datasheet
+
+    PwmBus         &_bus;                  /**< The I2C bus the board is on. */
+    uint8_t         _i2c_addr;             /**< The I2C address of the board. */
+    PwmFrame        _frame;                /**< The outputs of the board. */
+    OutputScheduler _scheduler;            /**< Paces writes to once per PWM period. */
+    bool            _align_output;         /**< True if the schedule is lined up with the PWM periods of the board. */
+    bool            _attached;             /**< True if the board is configured and accepting writes. */
+    unsigned long   _attaches;             /**< Number of times the board was attached. */
+    unsigned long   _faults;               /**< Number of faults detected. */
+    unsigned long   _fault_start_us;       /**< micros() time of the last fault. */
+    unsigned long   _last_downtime_us;     /**< How long the board was detached the last time. */
+    unsigned long   _last_health_check_ms; /**< millis() time of the last health check. */
+    unsigned long   _next_attempt_ms;      /**< millis() time of the next re-attach attempt. */
+    unsigned long   _retry_backoff_ms;     /**< Wait before the attempt after the next failed one. */
+    bool            _bus_clear_requested;  /**< A re-attach attempt found the bus stuck. */
+
+    /**
+     * @brief Probes the board and writes its configuration.
+     *
+     * @return True if the board was configured, false otherwise.
+     */
+    bool _attach();
+
+    /**
+     * @brief Checks that MODE1 still holds the configuration written by _attach().
+     *
+     * @return True if the board is healthy, false otherwise.
+     */
+    bool _check_health();
+
+    /**
+     * @brief Marks the board detached and schedules an immediate re-attach.
+     */
+    void _detach();
+
+    /**
+     * @brief Tries to re-attach a detached board, or asks for a bus clear if the bus is stuck. Backs off if it fails.
+     */
+    void _try_reattach();
+};
+
+#endif // PWM_BOARD_HPP
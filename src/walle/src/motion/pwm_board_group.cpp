@@ -0,0 +1,62 @@
+/**
+ * @file pwm_board_group.cpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the implementation of the PwmBoardGroup class, which manages every PCA9685 board on the
+ * I2C bus as one address space of PWM outputs.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "pwm_board_group.hpp"
+
+PwmBoardGroup::PwmBoardGroup(PwmBus &bus, const uint8_t *i2c_addrs, int num_boards)
+    : _bus(bus), _num_boards(constrain(num_boards, 0, MAX_BOARDS)), _bus_cleared(false), _last_bus_clear_ms(0) {
+    for (int board = 0; board < MAX_BOARDS; board++) {
+        _boards[board] = board < _num_boards ? new PwmBoard(bus, i2c_addrs[board]) : nullptr;
+    }
+}
+
+int PwmBoardGroup::begin(uint32_t oscillator_freq, float freq, unsigned long output_lead_us) {
+    int attached = 0;
+    for (int board = 0; board < _num_boards; board++) {
+        if (_boards[board]->begin(oscillator_freq, freq, output_lead_us)) {
+            attached++;
+        }
+    }
+    return attached;
+}
+
+void PwmBoardGroup::update(unsigned long now_us) {
+    bool clear_requested = false;
+    for (int board = 0; board < _num_boards; board++) {
+        _boards[board]->update(now_us);
+        clear_requested |= _boards[board]->take_bus_clear_request();
+    }
+    // One clear serves every board on the bus
+    if (clear_requested && (!_bus_cleared || millis() - _last_bus_clear_ms >= _BUS_CLEAR_INTERVAL_MS)) {
+        _bus.clear();
+        _bus_cleared = true;
+        _last_bus_clear_ms = millis();
+    }
+}
+
+int PwmBoardGroup::get_num_boards() {
+    return _num_boards;
+}
+
+PwmBoard *PwmBoardGroup::get_board(int board) {
+    if (board < 0 || board >= _num_boards) {
+        return nullptr;
+    }
+    return _boards[board];
+}
+
+PwmFrame *PwmBoardGroup::get_frame(PwmAddress address) {
+    PwmBoard *board = get_board(address.board);
+    if (board == nullptr || address.channel >= PwmFrame::NUM_CHANNELS) {
+        return nullptr;
+    }
+    return &board->get_frame();
+}
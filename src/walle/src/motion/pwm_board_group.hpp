@@ -0,0 +1,94 @@
+/**
+ * @file pwm_board_group.hpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the declaration of the PwmBoardGroup class, which manages every PCA9685 board on the I2C
+ * bus as one address space of PWM outputs.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef PWM_BOARD_GROUP_HPP
+#define PWM_BOARD_GROUP_HPP
+
+#include <Arduino.h>
+#include "pwm_address.hpp"
+#include "pwm_board.hpp"
+#include "pwm_bus.hpp"
+
+/**
+ * @brief A set of PCA9685 boards sharing one I2C bus.
+ *
+ * Outputs are addressed with a PwmAddress, where the board is the index of its I2C address in the list passed to the
+ * constructor. Every board has its own PwmFrame and output schedule, so each one is flushed in its own burst and adding
+ * a board adds one transaction per PWM period, however many of its channels changed.
+ *
+ * When a board finds the bus stuck, update() clears it once for every board. Clearing restarts the bus under the
+ * healthy boards too, so it happens at most once per _BUS_CLEAR_INTERVAL_MS.
+ */
+class PwmBoardGroup {
+  public:
+    static const int MAX_BOARDS = 8; ///< Maximum number of boards in a group
+
+    /**
+     * @brief Constructs a PwmBoardGroup object. Nothing is sent to the boards until begin() is called.
+     *
+     * @param bus The I2C bus the boards are on.
+     * @param i2c_addrs The I2C address of each board. Board n of a PwmAddress is i2c_addrs[n].
+     * @param num_boards The number of boards, at most MAX_BOARDS.
+     */
+    PwmBoardGroup(PwmBus &bus, const uint8_t *i2c_addrs, int num_boards);
+
+    /**
+     * @brief Begins every board. Boards that don't respond are attached by update() once they do.
+     *
+     * @param oscillator_freq The oscillator frequency of the PCA9685s in Hz.
+     * @param freq The PWM frequency in Hz.
+     * @param output_lead_us How long before each PWM period starts the outputs are written. See PwmBoard::begin().
+     * @return The number of boards that attached.
+     */
+    int begin(uint32_t oscillator_freq, float freq, unsigned long output_lead_us = 0);
+
+    /**
+     * @brief Updates every board, writing the ones whose output is due. Must be called from the task that owns the
+     * bus.
+     *
+     * @param now_us The current micros() time.
+     */
+    void update(unsigned long now_us);
+
+    /**
+     * @brief Gets the number of boards in the group.
+     *
+     * @return The number of boards.
+     */
+    int get_num_boards();
+
+    /**
+     * @brief Gets a board by its index.
+     *
+     * @param board The index of the board.
+     * @return The board, or nullptr if there is no board at that index.
+     */
+    PwmBoard *get_board(int board);
+
+    /**
+     * @brief Gets the frame holding an output.
+     *
+     * @param address The address of the output.
+     * @return The frame of the output's board, or nullptr if the address is not in the group.
+     */
+    PwmFrame *get_frame(PwmAddress address);
+
+  private:
+    static const unsigned long _BUS_CLEAR_INTERVAL_MS = 1000;
+
+    PwmBus       &_bus;                  /**< The I2C bus the boards are on. */
+    PwmBoard     *_boards[MAX_BOARDS];   /**< The boards, allocated once at construction. */
+    int           _num_boards;           /**< The number of boards. */
+    bool          _bus_cleared;          /**< The bus has been cleared at least once. */
+    unsigned long _last_bus_clear_ms;    /**< millis() time of the last bus clear. */
+};
+
+#endif // PWM_BOARD_GROUP_HPP
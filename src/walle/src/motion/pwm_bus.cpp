@@ -0,0 +1,105 @@
+/**
+ * @file pwm_bus.cpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the implementation of the PwmBus class, which wraps the I2C bus the PCA9685 boards are on
+ * and can recover it when a device holds it stuck.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "pwm_bus.hpp"
+
+PwmBus::PwmBus(TwoWire &i2c, int sda_pin, int scl_pin)
+    : _i2c(i2c), _sda_pin(sda_pin), _scl_pin(scl_pin), _clock_hz(0), _clears(0), _last_error(0) {
+}
+
+void PwmBus::begin() {
+    if (_clock_hz == 0) {
+        _i2c.begin(_sda_pin, _scl_pin);
+        _clock_hz = _i2c.getClock();
+    } else {
+        _i2c.begin(_sda_pin, _scl_pin, _clock_hz);
+    }
+    _i2c.setTimeOut(_TIMEOUT_MS);
+}
+
+bool PwmBus::clear() {
+    _clears++;
+    _i2c.end();
+
+    // Take the pins over from the I2C peripheral. Open drain, so the bus pull-ups drive the high level like usual.
+    pinMode(_sda_pin, INPUT_PULLUP);
+    pinMode(_scl_pin, OUTPUT_OPEN_DRAIN);
+    digitalWrite(_scl_pin, HIGH);
+    delayMicroseconds(_CLEAR_HALF_CLOCK_US);
+
+    // A device stuck mid-byte waits for clocks before it lets go of SDA. Clock until it does.
+    for (int i = 0; i < _CLEAR_CLOCK_PULSES && digitalRead(_sda_pin) == LOW; i++) {
+        digitalWrite(_scl_pin, LOW);
+        delayMicroseconds(_CLEAR_HALF_CLOCK_US);
+        digitalWrite(_scl_pin, HIGH);
+        delayMicroseconds(_CLEAR_HALF_CLOCK_US);
+    }
+    bool released = digitalRead(_sda_pin) == HIGH;
+
+    // Send a STOP (SDA rising while SCL is high) so every device drops whatever transfer it thought was going on
+    pinMode(_sda_pin, OUTPUT_OPEN_DRAIN);
+    digitalWrite(_scl_pin, LOW);
+    delayMicroseconds(_CLEAR_HALF_CLOCK_US);
+    digitalWrite(_sda_pin, LOW);
+    delayMicroseconds(_CLEAR_HALF_CLOCK_US);
+    digitalWrite(_scl_pin, HIGH);
+    delayMicroseconds(_CLEAR_HALF_CLOCK_US);
+    digitalWrite(_sda_pin, HIGH);
+    delayMicroseconds(_CLEAR_HALF_CLOCK_US);
+
+    begin();
+    return released;
+}
+
+bool PwmBus::is_sda_low() {
+    return digitalRead(_sda_pin) == LOW;
+}
+
+bool PwmBus::had_bus_error() {
+    // 2 and 3 are NACKs of the address and of the data, anything else but 0 went wrong on the bus
+    return _last_error != 0 && _last_error != 2 && _last_error != 3;
+}
+
+bool PwmBus::probe(uint8_t i2c_addr) {
+    _i2c.beginTransmission(i2c_addr);
+    _last_error = _i2c.endTransmission();
+    return _last_error == 0;
+}
+
+bool PwmBus::write_register(uint8_t i2c_addr, uint8_t reg, uint8_t value) {
+    _i2c.beginTransmission(i2c_addr);
+    _i2c.write(reg);
+    _i2c.write(value);
+    _last_error = _i2c.endTransmission();
+    return _last_error == 0;
+}
+
+bool PwmBus::read_register(uint8_t i2c_addr, uint8_t reg, uint8_t *value) {
+    _i2c.beginTransmission(i2c_addr);
+    _i2c.write(reg);
+    _last_error = _i2c.endTransmission();
+    if (_last_error != 0) {
+        return false;
+    }
+    if (_i2c.requestFrom(i2c_addr, (uint8_t)1) != 1) {
+        return false;
+    }
+    *value = _i2c.read();
+    return true;
+}
+
+TwoWire &PwmBus::get_wire() {
+    return _i2c;
+}
+
+unsigned long PwmBus::get_clears() {
+    return _clears;
+}
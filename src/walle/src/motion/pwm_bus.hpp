@@ -0,0 +1,118 @@
+/**
+ * @file pwm_bus.hpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the declaration of the PwmBus class, which wraps the I2C bus the PCA9685 boards are on and
+ * can recover it when a device holds it stuck.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef PWM_BUS_HPP
+#define PWM_BUS_HPP
+
+#include <Arduino.h>
+#include <Wire.h>
+
+/**
+ * @brief An I2C bus with register access helpers and bus-clear recovery.
+ *
+ * If a device loses track of a transfer, e.g. a brownout or noise in the middle of a byte, it can hold SDA low forever
+ * and every transaction on the bus fails. clear() releases the bus by clocking SCL by hand until the device lets go of
+ * SDA, sending a STOP, and restarting the Wire driver.
+ */
+class PwmBus {
+  public:
+    /**
+     * @brief Constructs a PwmBus object.
+     *
+     * @param i2c The I2C bus.
+     * @param sda_pin The SDA pin of the bus.
+     * @param scl_pin The SCL pin of the bus.
+     */
+    PwmBus(TwoWire &i2c = Wire, int sda_pin = SDA, int scl_pin = SCL);
+
+    /**
+     * @brief Starts the I2C bus.
+     */
+    void begin();
+
+    /**
+     * @brief Releases a stuck bus and restarts the Wire driver.
+     *
+     * @return True if SDA was released, false if it is still held low.
+     */
+    bool clear();
+
+    /**
+     * @brief Checks if something is holding SDA low. An idle bus has SDA high, so only call it between transactions.
+     *
+     * @return True if SDA is low.
+     */
+    bool is_sda_low();
+
+    /**
+     * @brief Checks if the last transaction failed on the bus itself, e.g. a timeout or lost arbitration, rather than
+     * because a device didn't acknowledge. A missing device only gives NACKs.
+     *
+     * @return True if the last probe, write or read had a bus error.
+     */
+    bool had_bus_error();
+
+    /**
+     * @brief Checks if a device acknowledges its address.
+     *
+     * @param i2c_addr The I2C address of the device.
+     * @return True if the device acknowledged, false otherwise.
+     */
+    bool probe(uint8_t i2c_addr);
+
+    /**
+     * @brief Writes one register of a device.
+     *
+     * @param i2c_addr The I2C address of the device.
+     * @param reg The register to write.
+     * @param value The value to write.
+     * @return True if the write was acknowledged, false otherwise.
+     */
+    bool write_register(uint8_t i2c_addr, uint8_t reg, uint8_t value);
+
+    /**
+     * @brief Reads one register of a device.
+     *
+     * @param i2c_addr The I2C address of the device.
+     * @param reg The register to read.
+     * @param[out] value The value read.
+     * @return True if the read succeeded, false otherwise.
+     */
+    bool read_register(uint8_t i2c_addr, uint8_t reg, uint8_t *value);
+
+    /**
+     * @brief Gets the underlying I2C bus.
+     *
+     * @return The I2C bus.
+     */
+    TwoWire &get_wire();
+
+    /**
+     * @brief Gets the number of times clear() was run.
+     *
+     * @return The number of bus clears.
+     */
+    unsigned long get_clears();
+
+  private:
+    static const int      _CLEAR_CLOCK_PULSES = 9;  // Enough to finish any byte plus its ACK
+    static const int      _CLEAR_HALF_CLOCK_US = 5; // ~100 kHz
+    static const uint16_t _TIMEOUT_MS = 10;         // Well under the default 50 ms, a 16 channel burst takes ~6 ms
+
+    TwoWire      &_i2c;      /**< The I2C bus. */
+    int           _sda_pin;  /**< The SDA pin of the bus. */
+    int           _scl_pin;  /**< The SCL pin of the bus. */
+    uint32_t      _clock_hz; /**< The bus clock, restored after a clear. 0 until begin(). */
+    unsigned long _clears;   /**< Number of bus clears. */
+    uint8_t       _last_error; /**< endTransmission() result of the last transaction, 0 if it succeeded. */
+};
+
+#endif // PWM_BUS_HPP
@@ -0,0 +1,150 @@
+/**
+ * @file pwm_frame.cpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the implementation of the PwmFrame class, which collects the output of every channel on a
+ * PCA9685 and writes them to the board in bursts.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "pwm_frame.hpp"
+
+PwmFrame::PwmFrame(uint8_t i2c_addr, TwoWire &i2c)
+    : _i2c(i2c), _i2c_addr(i2c_addr), _dirty_mask(0), _ticks_per_us_q16(0), _period_us(0), _prescale(0),
+      _transactions(0), _channel_writes(0), _errors(0), _last_error(0), _latency_stats(Stats(0.99)),
+      _latency_average_us(0), _latency_max_us(0) {
+    for (int channel = 0; channel < NUM_CHANNELS; channel++) {
+        _off_ticks[channel] = 0;
+    }
+}
+
+void PwmFrame::set_pwm_freq(uint32_t oscillator_freq, float freq) {
+    // Mirror the prescaler calculation in Adafruit_PWMServoDriver::setPWMFreq() so the result matches what the
+    // PCA9685 was actually programmed with. This only runs at setup, so floating point is fine here.
+    freq = constrain(freq, _FREQ_MIN_HZ, _FREQ_MAX_HZ);
+    float prescaleval = ((oscillator_freq / (freq * _TICKS_PER_PERIOD)) + 0.5) - 1;
+    prescaleval = constrain(prescaleval, _PRESCALE_MIN, _PRESCALE_MAX);
+    uint8_t prescale = (uint8_t)prescaleval;
+    _prescale = prescale;
+
+    // One tick lasts (prescale + 1) oscillator cycles
+    _ticks_per_us_q16 = (uint32_t)(((uint64_t)oscillator_freq << 16) / (1000000ULL * (prescale + 1)));
+    _period_us = (uint32_t)((1000000ULL * _TICKS_PER_PERIOD * (prescale + 1)) / oscillator_freq);
+}
+
+void PwmFrame::set_ticks(uint8_t channel, uint16_t ticks) {
+    if (channel >= NUM_CHANNELS) {
+        return;
+    }
+    ticks = min(ticks, (uint16_t)(_TICKS_PER_PERIOD - 1));
+    if (_off_ticks[channel] != ticks) {
+        _off_ticks[channel] = ticks;
+        _dirty_mask |= (1 << channel);
+    }
+}
+
+uint16_t PwmFrame::us_to_ticks(unsigned int us) {
+    // Q16 multiply, rounded to the nearest tick. 2500 us * ~13400 (0.205 ticks/us in Q16) fits easily in 32 bits.
+    return (uint16_t)((us * _ticks_per_us_q16 + (1 << 15)) >> 16);
+}
+
+uint32_t PwmFrame::get_ticks_per_us_q16() {
+    return _ticks_per_us_q16;
+}
+
+uint32_t PwmFrame::get_period_us() {
+    return _period_us;
+}
+
+uint8_t PwmFrame::get_prescale() {
+    return _prescale;
+}
+
+bool PwmFrame::flush() {
+    int channel = 0;
+    while (_dirty_mask != 0 && channel < NUM_CHANNELS) {
+        if (!(_dirty_mask & (1 << channel))) {
+            channel++;
+            continue;
+        }
+
+        // Extend the run over following dirty channels, bridging short gaps of clean ones
+        int run_last = channel;
+        for (int next = channel + 1; next < NUM_CHANNELS && next - run_last <= _MAX_MERGE_GAP_CHANNELS + 1; next++) {
+            if (_dirty_mask & (1 << next)) {
+                run_last = next;
+            }
+        }
+
+        if (!_write_run(channel, run_last)) {
+            // Leave the dirty bits set so the next flush retries. Don't try the remaining runs, if the bus is stuck
+            // each one would wait out the full I2C timeout.
+            return false;
+        }
+        // Clear the dirty bits for the run
+        for (int written = channel; written <= run_last; written++) {
+            _dirty_mask &= ~(1 << written);
+        }
+        channel = run_last + 1;
+    }
+    return true;
+}
+
+void PwmFrame::invalidate() {
+    _dirty_mask = (1 << NUM_CHANNELS) - 1;
+}
+
+unsigned long PwmFrame::get_transactions() {
+    return _transactions;
+}
+
+unsigned long PwmFrame::get_channel_writes() {
+    return _channel_writes;
+}
+
+unsigned long PwmFrame::get_errors() {
+    return _errors;
+}
+
+uint8_t PwmFrame::get_last_error() {
+    return _last_error;
+}
+
+uint32_t PwmFrame::get_latency_average_us() {
+    return _latency_average_us;
+}
+
+uint32_t PwmFrame::get_latency_max_us() {
+    return _latency_max_us;
+}
+
+bool PwmFrame::_write_run(int first, int last) {
+    // With auto-increment on, the PCA9685 steps through LEDn_ON_L, LEDn_ON_H, LEDn_OFF_L, LEDn_OFF_H and on into the
+    // next channel's registers, so the whole run goes out after a single register address.
+    unsigned long start_us = micros();
+    _i2c.beginTransmission(_i2c_addr);
+    _i2c.write(PCA9685_LED0_ON_L + _REGISTERS_PER_CHANNEL * first);
+    for (int channel = first; channel <= last; channel++) {
+        // Outputs always turn on at tick 0 and off after _off_ticks
+        _i2c.write(0);
+        _i2c.write(0);
+        _i2c.write(_off_ticks[channel] & 0xFF);
+        _i2c.write(_off_ticks[channel] >> 8);
+    }
+    uint8_t result = _i2c.endTransmission();
+
+    // The ESP32 Wire library sends the whole transaction in endTransmission(), so this covers the bus time
+    _latency_stats.addNumber(micros() - start_us);
+    _latency_average_us = (uint32_t)_latency_stats.average();
+    _latency_max_us = (uint32_t)_latency_stats.max();
+    _transactions++;
+    if (result != 0) {
+        _errors++;
+        _last_error = result;
+        return false;
+    }
+    _channel_writes += last - first + 1;
+    return true;
+}
@@ -0,0 +1,184 @@
+/**
+ * @file pwm_frame.hpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the declaration of the PwmFrame class, which collects the output of every channel on a
+ * PCA9685 for one control tick and writes them to the board in as few I2C transactions as possible.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef PWM_FRAME_HPP
+#define PWM_FRAME_HPP
+
+#include <Adafruit_PWMServoDriver.h>
+#include <Arduino.h>
+#include <Wire.h>
+#include "../stats/stats.hpp"
+
+/**
+ * @brief Holds the pulse width of all 16 channels of a PCA9685 and flushes them to the board in bursts.
+ *
+ * Motors write their pulse widths into the frame during a tick and flush() sends every channel that changed. Runs of
+ * neighbouring dirty channels are sent as one auto-increment write starting at their LEDn_ON_L register, so a full
+ * update is usually a single I2C transaction and every joint changes in the same PWM period.
+ *
+ * NOTE: Auto-increment (MODE1 AI) must be enabled on the PCA9685. PwmBoard enables it when it attaches the board.
+ * The ESP32 Wire buffer is 128 bytes, which fits all 16 channels (65 bytes) in one transaction.
+ */
+class PwmFrame {
+  public:
+    static const int NUM_CHANNELS = 16; ///< Number of PWM channels on a PCA9685
+
+    /**
+     * @brief Constructs a PwmFrame object. All channels start clean and off.
+     *
+     * @param i2c_addr The I2C address of the PCA9685.
+     * @param i2c The I2C bus the PCA9685 is connected to.
+     */
+    PwmFrame(uint8_t i2c_addr = PCA9685_I2C_ADDRESS, TwoWire &i2c = Wire);
+
+    /**
+     * @brief Calculates the microsecond to tick conversion for the given PWM frequency. This must be called with the
+     * same values passed to Adafruit_PWMServoDriver::setOscillatorFrequency() and setPWMFreq(). The prescaler is
+     * derived the same way the driver derives it, so nothing has to be read back from the PCA9685.
+     *
+     * @param oscillator_freq The oscillator frequency of the PCA9685 in Hz.
+     * @param freq The PWM frequency in Hz.
+     */
+    void set_pwm_freq(uint32_t oscillator_freq, float freq);
+
+    /**
+     * @brief Sets the OFF time of a channel in ticks (0-4095). The channel is only marked dirty if the value changed.
+     *
+     * @param channel The channel to set (0-15).
+     * @param ticks The number of ticks the output is high for at the start of each PWM period.
+     */
+    void set_ticks(uint8_t channel, uint16_t ticks);
+
+    /**
+     * @brief Converts a pulse width in microseconds to PCA9685 ticks, rounded to the nearest tick. Integer only.
+     *
+     * @param us The pulse width in microseconds.
+     * @return The pulse width in ticks.
+     */
+    uint16_t us_to_ticks(unsigned int us);
+
+    /**
+     * @brief Gets the number of ticks per microsecond as an unsigned Q16 fixed point value. 0 until set_pwm_freq() is
+     * called.
+     *
+     * @return The ticks per microsecond in Q16.
+     */
+    uint32_t get_ticks_per_us_q16();
+
+    /**
+     * @brief Gets the length of one PWM period in microseconds, as set by set_pwm_freq(). This is the period the
+     * prescaler actually produces, which is slightly off the requested frequency. 0 until set_pwm_freq() is called.
+     *
+     * @return The PWM period in microseconds.
+     */
+    uint32_t get_period_us();
+
+    /**
+     * @brief Gets the prescaler value matching the frequency passed to set_pwm_freq().
+     *
+     * @return The value for the PCA9685 PRESCALE register.
+     */
+    uint8_t get_prescale();
+
+    /**
+     * @brief Writes all dirty channels to the PCA9685. Neighbouring dirty channels are merged into one burst, and
+     * clean gaps of up to _MAX_MERGE_GAP_CHANNELS are rewritten when that is cheaper than starting a new transaction.
+     * Stops at the first failed transaction; unsent channels stay dirty for the next flush.
+     *
+     * @return True if every transaction was acknowledged, false otherwise.
+     */
+    bool flush();
+
+    /**
+     * @brief Marks every channel dirty so the next flush() rewrites the whole board.
+     */
+    void invalidate();
+
+    /**
+     * @brief Gets the number of I2C transactions sent by flush().
+     *
+     * @return The number of transactions.
+     */
+    unsigned long get_transactions();
+
+    /**
+     * @brief Gets the number of channel writes sent by flush(), including clean channels merged into a burst.
+     *
+     * @return The number of channel writes.
+     */
+    unsigned long get_channel_writes();
+
+    /**
+     * @brief Gets the number of transactions that were not acknowledged.
+     *
+     * @return The number of failed transactions.
+     */
+    unsigned long get_errors();
+
+    /**
+     * @brief Gets the result of the last failed transaction, as returned by TwoWire::endTransmission().
+     *
+     * @return The last error code, 0 if no transaction has failed.
+     */
+    uint8_t get_last_error();
+
+    /**
+     * @brief Gets the average time a transaction takes, in microseconds.
+     *
+     * @return The average transaction latency in microseconds.
+     */
+    uint32_t get_latency_average_us();
+
+    /**
+     * @brief Gets the longest time a transaction took, in microseconds.
+     *
+     * @return The maximum transaction latency in microseconds.
+     */
+    uint32_t get_latency_max_us();
+
+  private:
+    // Each channel takes 4 bytes in a burst, a new transaction costs a start, address, register and stop. Rewriting a
+    // single clean channel is cheaper than splitting the burst in two.
+    static const int _MAX_MERGE_GAP_CHANNELS = 1;
+    static const int _REGISTERS_PER_CHANNEL = 4;
+    static const int _TICKS_PER_PERIOD = 4096;
+    static const int _PRESCALE_MIN = 3;      // Same limits as Adafruit_PWMServoDriver::setPWMFreq()
+    static const int _PRESCALE_MAX = 255;
+    static const int _FREQ_MIN_HZ = 1;
+    static const int _FREQ_MAX_HZ = 3500;
+
+    TwoWire &_i2c;                        /**< The I2C bus the PCA9685 is connected to. */
+    uint8_t  _i2c_addr;                   /**< The I2C address of the PCA9685. */
+    uint16_t _off_ticks[NUM_CHANNELS];    /**< The OFF time of each channel in ticks. */
+    uint16_t _dirty_mask;                 /**< Bit n is set if channel n needs to be written. */
+    uint32_t _ticks_per_us_q16;           /**< Ticks per microsecond, unsigned Q16. */
+    uint32_t _period_us;                  /**< Length of one PWM period in microseconds. */
+    uint8_t  _prescale;                   /**< Value of the PRESCALE register for the PWM frequency. */
+    unsigned long _transactions;          /**< Number of I2C transactions sent. */
+    unsigned long _channel_writes;        /**< Number of channels written. */
+    unsigned long _errors;                /**< Number of transactions that were not acknowledged. */
+    uint8_t  _last_error;                 /**< endTransmission() result of the last failed transaction. */
+    Stats    _latency_stats;              /**< Transaction latency in microseconds. Only touched by the flushing task. */
+    // Snapshots of _latency_stats for other tasks to read, its doubles aren't atomic on the ESP32
+    volatile uint32_t _latency_average_us; /**< Average transaction latency in microseconds. */
+    volatile uint32_t _latency_max_us;     /**< Maximum transaction latency in microseconds. */
+
+    /**
+     * @brief Writes channels first to last (inclusive) in one auto-increment transaction.
+     *
+     * @param first The first channel to write.
+     * @param last The last channel to write.
+     * @return True if the transaction was acknowledged, false otherwise.
+     */
+    bool _write_run(int first, int last);
+};
+
+#endif // PWM_FRAME_HPP
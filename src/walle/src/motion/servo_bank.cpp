@@ -0,0 +1,228 @@
+/**
+ * @file servo_bank.cpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the implementation of the ServoBank class, which holds the state of every servo in flat
+ * arrays and updates them all in one pass.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "servo_bank.hpp"
+
+ServoBank::ServoBank(PwmBoardGroup *pwm_boards, const ServoJoint *joints, int num_joints)
+    : _joints(joints), _num_servos(min(num_joints, (int)MAX_SERVOS)), _writes_issued(0), _writes_skipped(0) {
+    for (int id = 0; id < _num_servos; id++) {
+        _frames[id] = pwm_boards->get_frame(joints[id].address);
+        _channels[id] = joints[id].address.channel;
+        _last_written_ticks[id] = -1; // Nothing has been written yet, so the first update always goes out
+        _output_us[id] = joints[id].neutral_us;
+
+        // Start at neutral with no ramp running
+        _current_us[id] = joints[id].neutral_us;
+        _start_us[id] = joints[id].neutral_us;
+        _target_us[id] = joints[id].neutral_us;
+        _ramp_start_us[id] = 0;
+        _ramp_duration_us[id] = 0;
+        _ramp_rate[id] = 0;
+        _ramp_starting[id] = false;
+        _ease[id] = ease_function(joints[id].ramp);
+        _start_tangent_us[id] = 0;
+        _end_tangent_us[id] = 0;
+
+        _servos[id] = ServoMotor(this, id);
+    }
+}
+
+int ServoBank::get_num_servos() {
+    return _num_servos;
+}
+
+ServoMotor *ServoBank::get_servo(int id) {
+    if (id < 0 || id >= _num_servos) {
+        return nullptr;
+    }
+    return &_servos[id];
+}
+
+void ServoBank::update_all(unsigned long now_us) {
+    update_ramps(now_us);
+    for (int i = 0; i < _num_servos; i++) {
+        _output_us[i] = _current_us[i];
+    }
+    write_outputs();
+}
+
+void ServoBank::update_ramps(unsigned long now_us) {
+    // Advance the ramps. Finished ramps just hold their target.
+    for (int i = 0; i < _num_servos; i++) {
+        if (_ramp_starting[i]) {
+            _ramp_start_us[i] = now_us;
+            _ramp_starting[i] = false;
+        }
+        unsigned long elapsed_us = now_us - _ramp_start_us[i];
+        if (elapsed_us >= _ramp_duration_us[i]) {
+            _current_us[i] = _target_us[i];
+        } else {
+            q16_t progress = q16_progress(elapsed_us, _ramp_rate[i]);
+            _current_us[i] = _start_us[i] + q16_mul(_target_us[i] - _start_us[i], _ease[i](progress));
+            if ((_start_tangent_us[i] | _end_tangent_us[i]) != 0) {
+                // A spline can swing past the points it runs through, so keep it inside the joint's limits
+                _current_us[i] += q16_mul(_start_tangent_us[i], q16_hermite_h10(progress)) +
+                                  q16_mul(_end_tangent_us[i], q16_hermite_h11(progress));
+                _current_us[i] = constrain(_current_us[i], _joints[i].min_us, _joints[i].max_us);
+            }
+        }
+    }
+}
+
+void ServoBank::write_outputs() {
+    // Write the outputs. Skip the frame write if the PCA9685 is already outputting this pulse width; neighbouring us
+    // values often land on the same tick.
+    for (int i = 0; i < _num_servos; i++) {
+        if (_frames[i] == nullptr) {
+            continue;
+        }
+        uint16_t ticks = _frames[i]->us_to_ticks(_output_us[i]);
+        if (ticks == _last_written_ticks[i]) {
+            _writes_skipped++;
+            continue;
+        }
+        _frames[i]->set_ticks(_channels[i], ticks);
+        _last_written_ticks[i] = ticks;
+        _writes_issued++;
+    }
+}
+
+int ServoBank::get_ramp_us(int id) {
+    return _current_us[id];
+}
+
+void ServoBank::set_output_us(int id, int us) {
+    _output_us[id] = constrain(us, _joints[id].min_us, _joints[id].max_us);
+}
+
+void ServoBank::set_scalars(const float *scalars) {
+    for (int i = 0; i < _num_servos; i++) {
+        set_scalar(i, scalars[i], 0);
+    }
+}
+
+void ServoBank::get_scalars(float *scalars) {
+    for (int i = 0; i < _num_servos; i++) {
+        scalars[i] = us_to_scalar(i, _output_us[i]);
+    }
+}
+
+void ServoBank::set_us(int id, int us, unsigned long time_ms) {
+    _target_us[id] = constrain(us, _joints[id].min_us, _joints[id].max_us);
+    _ramp_duration_us[id] = time_ms * 1000UL;
+    _start_tangent_us[id] = 0;
+    _end_tangent_us[id] = 0;
+    if (time_ms == 0) {
+        _current_us[id] = _target_us[id];
+        _ramp_starting[id] = false;
+        return;
+    }
+    // Ramp from wherever the servo is now. The one division of the ramp is done here, so update_all() only multiplies.
+    _start_us[id] = _current_us[id];
+    _ramp_rate[id] = q16_progress_rate(_ramp_duration_us[id]);
+    _ramp_starting[id] = true;
+}
+
+void ServoBank::set_us(int id, int us, unsigned long time_ms, unsigned long start_us) {
+    set_us(id, us, time_ms);
+    if (time_ms != 0) {
+        _ramp_start_us[id] = start_us;
+        _ramp_starting[id] = false;
+    }
+}
+
+void ServoBank::set_scalar(int id, float scalar, unsigned long time_ms) {
+    set_us(id, scalar_to_us(id, scalar), time_ms);
+}
+
+void ServoBank::set_scalar(int id, float scalar, unsigned long time_ms, unsigned long start_us) {
+    set_us(id, scalar_to_us(id, scalar), time_ms, start_us);
+}
+
+void ServoBank::set_angle(int id, float angle_deg, unsigned long time_ms) {
+    set_us(id, (int)angle_to_us(id, angle_deg), time_ms);
+}
+
+void ServoBank::set_tangents(int id, int start_tangent_us, int end_tangent_us) {
+    _start_tangent_us[id] = start_tangent_us;
+    _end_tangent_us[id] = end_tangent_us;
+}
+
+void ServoBank::set_ramp_mode(int id, ramp_mode mode) {
+    _ease[id] = ease_function(mode);
+}
+
+const ServoJoint &ServoBank::get_joint(int id) {
+    return _joints[id];
+}
+
+int ServoBank::get_current_us(int id) {
+    return _output_us[id];
+}
+
+float ServoBank::us_to_scalar(int id, int us) {
+    const ServoJoint &joint = _joints[id];
+    if (us > joint.neutral_us) {
+        return (float)(us - joint.neutral_us) / joint.scalar_plus_to_us_slope;
+    } else {
+        return (float)(us - joint.neutral_us) / joint.scalar_minus_to_us_slope;
+    }
+}
+
+int ServoBank::scalar_to_us(int id, float scalar) {
+    // Account for the asymetric mapping of min_us and max_us around neutral
+    const ServoJoint &joint = _joints[id];
+    float             slope = scalar > 0 ? joint.scalar_plus_to_us_slope : joint.scalar_minus_to_us_slope;
+    return constrain((int)lroundf(scalar * slope + joint.neutral_us), joint.min_us, joint.max_us);
+}
+
+float ServoBank::us_to_angle(int id, int us) {
+    const ServoJoint &joint = _joints[id];
+    if (us > joint.neutral_us) {
+        return (float)(us - joint.neutral_us) / joint.angle_plus_to_us_slope + joint.neutral_angle_deg;
+    } else {
+        return (float)(us - joint.neutral_us) / joint.angle_minus_to_us_slope + joint.neutral_angle_deg;
+    }
+}
+
+float ServoBank::angle_to_us(int id, float angle_deg) {
+    const ServoJoint &joint = _joints[id];
+    if (angle_deg > joint.neutral_angle_deg) {
+        return (angle_deg - joint.neutral_angle_deg) * joint.angle_plus_to_us_slope + joint.neutral_us;
+    } else {
+        return (angle_deg - joint.neutral_angle_deg) * joint.angle_minus_to_us_slope + joint.neutral_us;
+    }
+}
+
+float ServoBank::angle_to_scalar(int id, float angle_deg) {
+    const ServoJoint &joint = _joints[id];
+    if (angle_deg > joint.neutral_angle_deg) {
+        return (angle_deg - joint.neutral_angle_deg) / (joint.max_angle_deg - joint.neutral_angle_deg);
+    } else {
+        return (angle_deg - joint.neutral_angle_deg) / (joint.neutral_angle_deg - joint.min_angle_deg);
+    }
+}
+
+const char *ServoBank::get_name(int id) {
+    return _joints[id].name;
+}
+
+PwmAddress ServoBank::get_address(int id) {
+    return _joints[id].address;
+}
+
+unsigned long ServoBank::get_writes_issued() {
+    return _writes_issued;
+}
+
+unsigned long ServoBank::get_writes_skipped() {
+    return _writes_skipped;
+}
@@ -0,0 +1,309 @@
+/**
+ * @file servo_bank.hpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the declaration of the ServoBank class, which holds the state of every servo in flat
+ * arrays and updates them all in one pass.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef SERVO_BANK_HPP
+#define SERVO_BANK_HPP
+
+#include "easing.hpp"
+#include "pwm_board_group.hpp"
+#include "servo_joint.hpp"
+#include "servo_motor.hpp"
+#include <Arduino.h>
+
+/**
+ * @brief Stores every servo's ramp and output state in arrays indexed by servo ID.
+ *
+ * The servos are described by a constexpr table of ServoJoints, and the ID of a servo is its index in the table. Limits
+ * and conversion slopes are read straight from the table, which stays in flash. update_all() runs every ramp as one
+ * loop over the ramp arrays and then writes every changed pulse width to the PWM frames in a second loop, so the
+ * per-tick work is the same few array passes however many joints there are.
+ *
+ * The ramps are timed by the micros() time handed to update_all(), so one timestamp serves every servo in a tick and
+ * the bank never reads the clock itself. A ramp started with set_us() begins at the next update_all(). Progress is
+ * Q16 fixed point and eased by the curve ease_function() gives for the servo's ramp mode, normally a lookup table.
+ * A CATMULL_ROM ramp can also be given the tangents of a cubic Hermite segment with set_tangents(), so it leaves its
+ * start and reaches its target moving instead of at rest.
+ *
+ * The ramps can also be one layer of a ServoMixer, which calls update_ramps(), mixes the ramps with its other layers
+ * into the output pulse widths and then calls write_outputs(). update_all() does both with the ramps as the output.
+ *
+ * The ServoMotor returned by get_servo() is a handle into the bank for code that works with one servo at a time, like
+ * keyframes and the recorder.
+ *
+ * NOTE: The bank is owned by the motion task once it starts. Other tasks should only read from it.
+ */
+class ServoBank {
+  public:
+    static const int MAX_SERVOS = 16; ///< Maximum number of servos in a bank
+
+    /**
+     * @brief Constructs a ServoBank for a table of joints. Every servo starts at neutral and is written on the first
+     * update_all().
+     *
+     * @param pwm_boards Pointer to the PCA9685 boards the servos are connected to.
+     * @param joints The table of joints. Must outlive the bank, normally it is a constexpr global.
+     * @param num_joints The number of joints in the table. Joints past MAX_SERVOS are left out.
+     */
+    ServoBank(PwmBoardGroup *pwm_boards, const ServoJoint *joints, int num_joints);
+
+    /**
+     * @brief Gets the number of servos in the bank. IDs run from 0 to get_num_servos() - 1.
+     *
+     * @return The number of servos.
+     */
+    int get_num_servos();
+
+    /**
+     * @brief Gets the handle of a servo.
+     *
+     * @param id The ID of the servo.
+     * @return The servo's handle, or nullptr if there is no servo with that ID.
+     */
+    ServoMotor *get_servo(int id);
+
+    /**
+     * @brief Advances every servo's ramp to the given time and writes the pulse widths that changed to the PWM frames.
+     *
+     * @param now_us The current micros() time, shared by every servo.
+     */
+    void update_all(unsigned long now_us);
+
+    /**
+     * @brief Advances every servo's ramp to the given time without touching the outputs.
+     *
+     * @param now_us The current micros() time, shared by every servo.
+     */
+    void update_ramps(unsigned long now_us);
+
+    /**
+     * @brief Writes the output pulse widths that changed to the PWM frames.
+     */
+    void write_outputs();
+
+    /**
+     * @brief Gets where a servo's ramp has it, which is not the output if a ServoMixer mixes in other layers.
+     *
+     * @param id The ID of the servo.
+     * @return The ramp's pulse width in microseconds.
+     */
+    int get_ramp_us(int id);
+
+    /**
+     * @brief Sets the pulse width write_outputs() sends for a servo.
+     *
+     * @param id The ID of the servo.
+     * @param us The pulse width in microseconds, limited to the servo's min and max.
+     */
+    void set_output_us(int id, int us);
+
+    /**
+     * @brief Moves every servo straight to a scalar, without a ramp.
+     *
+     * @param scalars One scalar per servo ID, -1.0 is min_us and 1.0 is max_us. Must hold get_num_servos() values.
+     */
+    void set_scalars(const float *scalars);
+
+    /**
+     * @brief Gets the current scalar of every servo.
+     *
+     * @param[out] scalars One scalar per servo ID, -1.0 is min_us and 1.0 is max_us. Must hold get_num_servos()
+     * values.
+     */
+    void get_scalars(float *scalars);
+
+    /**
+     * @brief Starts ramping a servo to a pulse width. The pulse width is limited to the servo's min and max.
+     *
+     * @param id The ID of the servo.
+     * @param us The target pulse width in microseconds.
+     * @param time_ms The time in milliseconds to reach the target, counted from the next update. 0 moves there on the
+     * next update.
+     */
+    void set_us(int id, int us, unsigned long time_ms);
+
+    /**
+     * @brief Starts ramping a servo to a pulse width as if the ramp had started at start_us. A start in the past picks
+     * the ramp up part way through, which keeps back to back ramps on an animation's timeline.
+     *
+     * @param id The ID of the servo.
+     * @param us The target pulse width in microseconds.
+     * @param time_ms The time in milliseconds to reach the target, counted from start_us.
+     * @param start_us The micros() time the ramp starts at.
+     */
+    void set_us(int id, int us, unsigned long time_ms, unsigned long start_us);
+
+    /**
+     * @brief Starts ramping a servo to a scalar.
+     *
+     * @param id The ID of the servo.
+     * @param scalar The target scalar. -1.0 is min_us, 1.0 is max_us.
+     * @param time_ms The time in milliseconds to reach the target.
+     */
+    void set_scalar(int id, float scalar, unsigned long time_ms);
+
+    /**
+     * @brief Starts ramping a servo to a scalar as if the ramp had started at start_us.
+     *
+     * @param id The ID of the servo.
+     * @param scalar The target scalar. -1.0 is min_us, 1.0 is max_us.
+     * @param time_ms The time in milliseconds to reach the target, counted from start_us.
+     * @param start_us The micros() time the ramp starts at.
+     */
+    void set_scalar(int id, float scalar, unsigned long time_ms, unsigned long start_us);
+
+    /**
+     * @brief Starts ramping a servo to an angle.
+     *
+     * @param id The ID of the servo.
+     * @param angle_deg The target angle in degrees.
+     * @param time_ms The time in milliseconds to reach the target.
+     */
+    void set_angle(int id, float angle_deg, unsigned long time_ms);
+
+    /**
+     * @brief Gives the ramp a servo was just set on the tangents of a cubic Hermite segment. Meant for CATMULL_ROM
+     * ramps, where the ease is the segment with no tangents. Every set_us() clears them.
+     *
+     * @param id The ID of the servo.
+     * @param start_tangent_us The speed at the start of the ramp, as the microseconds it would cover over the whole
+     * ramp at that speed.
+     * @param end_tangent_us The speed at the end of the ramp, in the same units.
+     */
+    void set_tangents(int id, int start_tangent_us, int end_tangent_us);
+
+    /**
+     * @brief Sets the easing curve of a servo's ramps, replacing the one from its joint. Also applies to a ramp that is
+     * already running.
+     *
+     * @param id The ID of the servo.
+     * @param mode The ramp mode.
+     */
+    void set_ramp_mode(int id, ramp_mode mode);
+
+    /**
+     * @brief Gets the description of a servo.
+     *
+     * @param id The ID of the servo.
+     * @return The servo's entry in the table of joints.
+     */
+    const ServoJoint &get_joint(int id);
+
+    /**
+     * @brief Gets the current pulse width of a servo, the one last sent to its output.
+     *
+     * @param id The ID of the servo.
+     * @return The current pulse width in microseconds.
+     */
+    int get_current_us(int id);
+
+    /**
+     * @brief Converts a pulse width to a servo's scalar.
+     *
+     * @param id The ID of the servo.
+     * @param us The pulse width in microseconds.
+     * @return The scalar. -1.0 is min_us, 1.0 is max_us.
+     */
+    float us_to_scalar(int id, int us);
+
+    /**
+     * @brief Converts a scalar to a servo's pulse width, the way set_scalar() does.
+     *
+     * @param id The ID of the servo.
+     * @param scalar The scalar. -1.0 is min_us, 1.0 is max_us.
+     * @return The pulse width in microseconds, rounded and limited to the servo's min and max.
+     */
+    int scalar_to_us(int id, float scalar);
+
+    /**
+     * @brief Converts a pulse width to a servo's angle.
+     *
+     * @param id The ID of the servo.
+     * @param us The pulse width in microseconds.
+     * @return The angle in degrees.
+     */
+    float us_to_angle(int id, int us);
+
+    /**
+     * @brief Converts an angle to a servo's pulse width.
+     *
+     * @param id The ID of the servo.
+     * @param angle_deg The angle in degrees.
+     * @return The pulse width in microseconds.
+     */
+    float angle_to_us(int id, float angle_deg);
+
+    /**
+     * @brief Converts an angle to a servo's scalar.
+     *
+     * @param id The ID of the servo.
+     * @param angle_deg The angle in degrees.
+     * @return The scalar. -1.0 is min_us, 1.0 is max_us.
+     */
+    float angle_to_scalar(int id, float angle_deg);
+
+    /**
+     * @brief Gets the name of a servo.
+     *
+     * @param id The ID of the servo.
+     * @return The name of the servo, from its ServoJoint.
+     */
+    const char *get_name(int id);
+
+    /**
+     * @brief Gets the board and channel a servo is connected to.
+     *
+     * @param id The ID of the servo.
+     * @return The address of the servo's output.
+     */
+    PwmAddress get_address(int id);
+
+    /**
+     * @brief Gets the number of pulse widths update_all() wrote to the PWM frames, over all servos.
+     *
+     * @return The number of writes issued.
+     */
+    unsigned long get_writes_issued();
+
+    /**
+     * @brief Gets the number of writes update_all() skipped because the pulse width had not changed, over all servos.
+     *
+     * @return The number of writes skipped.
+     */
+    unsigned long get_writes_skipped();
+
+  private:
+    const ServoJoint *_joints;         /**< The table of joints, in flash. */
+    int               _num_servos;     /**< The number of servos. */
+    unsigned long     _writes_issued;  /**< Number of pulse widths written to the PWM frames. */
+    unsigned long     _writes_skipped; /**< Number of updates that didn't need to write to the PWM frames. */
+
+    // Output
+    PwmFrame *_frames[MAX_SERVOS];             // PWM frame of each servo's board, nullptr if the address is invalid
+    uint8_t   _channels[MAX_SERVOS];           // Channel of each servo, copied from the table for update_all()
+    int       _last_written_ticks[MAX_SERVOS]; // Last ticks written to the frame, -1 if never written
+    int       _output_us[MAX_SERVOS];          // Pulse width to send, the ramp unless a ServoMixer set it
+
+    // Ramps
+    int           _current_us[MAX_SERVOS];
+    int           _start_us[MAX_SERVOS];
+    int           _target_us[MAX_SERVOS];
+    unsigned long _ramp_start_us[MAX_SERVOS];    // micros() time of the update the ramp started on
+    unsigned long _ramp_duration_us[MAX_SERVOS]; // 0 if no ramp is running
+    uint64_t      _ramp_rate[MAX_SERVOS];        // Q16 progress per microsecond, times 2^32
+    bool          _ramp_starting[MAX_SERVOS];    // The ramp starts on the next update_all()
+    EaseFunction  _ease[MAX_SERVOS];             // Easing curve of the ramp mode
+    int           _start_tangent_us[MAX_SERVOS]; // Hermite tangents of the ramp, both 0 for a plain eased ramp
+    int           _end_tangent_us[MAX_SERVOS];
+
+    ServoMotor _servos[MAX_SERVOS]; // Handles returned by get_servo()
+};
+
+#endif // SERVO_BANK_HPP
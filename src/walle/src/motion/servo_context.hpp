@@ -12,8 +12,9 @@
 #ifndef SEREVO_CONTEXT_HPP
 #define SEREVO_CONTEXT_HPP
 
+#include "servo_bank.hpp"
 #include "servo_motor.hpp"
-#include <map>
+#include <string.h>
 
 #define MOTOR_LEFT_NAME           "Left Track"
 #define MOTOR_RIGHT_NAME          "Right Track"
@@ -30,17 +31,116 @@
 #define SERVO_HAND_LEFT_NAME      "Left Hand"
 #define SERVO_HAND_RIGHT_NAME     "Right Hand"
 
+// ID of each servo in the ServoBank. initServos() adds the servos in this order.
+enum ServoId {
+    SERVO_ID_NECK_YAW,
+    SERVO_ID_NECK_PITCH,
+    SERVO_ID_EYE_LEFT,
+    SERVO_ID_EYE_RIGHT,
+    SERVO_ID_SHOULDER_LEFT,
+    SERVO_ID_SHOULDER_RIGHT,
+    SERVO_ID_ELBOW_LEFT,
+    SERVO_ID_ELBOW_RIGHT,
+    SERVO_ID_WRIST_LEFT,
+    SERVO_ID_WRIST_RIGHT,
+    SERVO_ID_HAND_LEFT,
+    SERVO_ID_HAND_RIGHT,
+    SERVO_ID_COUNT
+};
+
 /**
  * @brief The ServoContext class represents a context for servo motors.
  * 
  * TODO: This should be converted to a singleton class
  * 
- * This class provides a static map that associates servo motor names with their corresponding ServoMotor objects.
- * It allows easy access to servo motors by name throughout the application.
+ * This class is a registry of the servo motors, indexed by their servo ID (see ServoId), so looking a servo up is a
+ * single array access. Each servo's name is stored once, in its ServoJoint, and only used to save and load animations
+ * and to label the servos on the display. Servos can also be looked up by name or by the board and channel they are
+ * connected to, which are linear searches meant for loading and setup rather than the update path.
  */
 class ServoContext{
     public:
-        std::map <std::string, ServoMotor*> map;
+        static const int MAX_SERVOS = ServoBank::MAX_SERVOS; ///< Maximum number of servos in the context
+
+        /**
+         * @brief Constructs an empty ServoContext.
+         */
+        ServoContext() : _servos(), _num_servos(0) {
+        }
+
+        /**
+         * @brief Adds a servo to the context under its ID.
+         * 
+         * @param servo The servo to add.
+         * @return True if the servo was added, false if its ID is out of range or already taken, or another servo
+         * already uses its name or its board and channel.
+         */
+        bool add(ServoMotor *servo) {
+            int id = servo->get_id();
+            if (id < 0 || id >= MAX_SERVOS || _servos[id] != nullptr || find_id(servo->get_name()) >= 0 ||
+                find(servo->get_address()) != nullptr) {
+                return false;
+            }
+            _servos[id] = servo;
+            _num_servos = max(_num_servos, id + 1);
+            return true;
+        }
+
+        /**
+         * @brief Gets the number of servo IDs in use. IDs run from 0 to get_num_servos() - 1.
+         * 
+         * @return The number of servo IDs.
+         */
+        int get_num_servos() {
+            return _num_servos;
+        }
+
+        /**
+         * @brief Gets a servo by its ID.
+         * 
+         * @param id The ID of the servo.
+         * @return The servo, or nullptr if no servo has that ID.
+         */
+        ServoMotor *get(int id) {
+            if (id < 0 || id >= _num_servos) {
+                return nullptr;
+            }
+            return _servos[id];
+        }
+
+        /**
+         * @brief Finds the ID of a servo by its name.
+         * 
+         * @param name The name of the servo.
+         * @return The ID of the servo, or -1 if no servo has that name.
+         */
+        int find_id(const char *name) {
+            for (int id = 0; id < _num_servos; id++) {
+                if (_servos[id] != nullptr && strcmp(_servos[id]->get_name(), name) == 0) {
+                    return id;
+                }
+            }
+            return -1;
+        }
+
+        /**
+         * @brief Finds the servo connected to a board and channel.
+         * 
+         * @param address The board and channel to look up.
+         * @return The servo at that address, or nullptr if there is none.
+         */
+        ServoMotor *find(PwmAddress address) {
+            for (int id = 0; id < _num_servos; id++) {
+                if (_servos[id] != nullptr && _servos[id]->get_address() == address) {
+                    return _servos[id];
+                }
+            }
+            return nullptr;
+        }
+
+    private:
+        ServoMotor *_servos[MAX_SERVOS]; // Servos indexed by ID, nullptr for unused IDs
+        int         _num_servos;         // One more than the highest ID in use
 };
 
 #endif // SEREVO_CONTEXT_HPP
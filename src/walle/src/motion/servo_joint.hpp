@@ -0,0 +1,144 @@
+/**
+ * @file servo_joint.hpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the ServoJoint struct, a compile time description of one servo joint, and helpers to check
+ * a table of them at compile time.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef SERVO_JOINT_HPP
+#define SERVO_JOINT_HPP
+
+#include "easing.hpp"
+#include "pwm_address.hpp"
+
+/**
+ * @brief Describes one servo joint: where it is connected, its limits and how it moves.
+ *
+ * The conversion slopes are calculated by the constexpr constructor, so a constexpr table of joints is built entirely
+ * by the compiler and stored in flash. ServoBank reads the limits and slopes from the table instead of keeping its own
+ * copy.
+ */
+struct ServoJoint {
+    int         id;                // Index of the joint in its table, the servo ID in the bank
+    const char *name;              // Name of the joint, used for saving animations and on the display
+    PwmAddress  address;           // Board and channel the servo is connected to
+    int         min_us;            // Minimum pulse width in microseconds
+    int         neutral_us;        // Neutral pulse width in microseconds
+    int         max_us;            // Maximum pulse width in microseconds
+    float       min_angle_deg;     // Angle at min_us in degrees
+    float       neutral_angle_deg; // Angle at neutral_us in degrees
+    float       max_angle_deg;     // Angle at max_us in degrees
+    ramp_mode   ramp;              // Easing curve of the joint's ramps
+    float       rate_per_s;        // Manual control speed in full travel per second, negative reverses the control
+
+    float scalar_plus_to_us_slope;  // us per scalar above neutral
+    float scalar_minus_to_us_slope; // us per scalar below neutral
+    float angle_plus_to_us_slope;   // us per degree above the neutral angle
+    float angle_minus_to_us_slope;  // us per degree below the neutral angle
+
+    /**
+     * @brief Constructs a ServoJoint and calculates its conversion slopes.
+     *
+     * @param id Index of the joint in its table.
+     * @param name Name of the joint.
+     * @param address Board and channel the servo is connected to.
+     * @param min_us Minimum pulse width in microseconds.
+     * @param neutral_us Neutral pulse width in microseconds.
+     * @param max_us Maximum pulse width in microseconds.
+     * @param ramp Easing curve of the joint's ramps.
+     * @param rate_per_s Manual control speed in full travel per second.
+     * @param min_angle_deg Angle at min_us in degrees (default: -90).
+     * @param neutral_angle_deg Angle at neutral_us in degrees (default: 0).
+     * @param max_angle_deg Angle at max_us in degrees (default: 90).
+     */
+    constexpr ServoJoint(int id, const char *name, PwmAddress address, int min_us, int neutral_us, int max_us,
+                         ramp_mode ramp, float rate_per_s, float min_angle_deg = -90, float neutral_angle_deg = 0,
+                         float max_angle_deg = 90)
+        : id(id), name(name), address(address), min_us(min_us), neutral_us(neutral_us), max_us(max_us),
+          min_angle_deg(min_angle_deg), neutral_angle_deg(neutral_angle_deg), max_angle_deg(max_angle_deg),
+          ramp(ramp), rate_per_s(rate_per_s), scalar_plus_to_us_slope((float)(max_us - neutral_us)),
+          scalar_minus_to_us_slope((float)(neutral_us - min_us)),
+          angle_plus_to_us_slope((float)(max_us - neutral_us) / (max_angle_deg - neutral_angle_deg)),
+          angle_minus_to_us_slope((float)(neutral_us - min_us) / (neutral_angle_deg - min_angle_deg)) {
+    }
+
+    /**
+     * @brief Checks that the neutral pulse width and angle sit strictly between their min and max.
+     *
+     * @return True if the limits are in order, false otherwise.
+     */
+    constexpr bool limits_are_ordered() const {
+        return min_us < neutral_us && neutral_us < max_us && min_angle_deg < neutral_angle_deg &&
+               neutral_angle_deg < max_angle_deg;
+    }
+};
+
+/**
+ * @brief Checks every joint of a table for limits in order. Meant for static_assert().
+ *
+ * @param joints The table of joints.
+ * @param num_joints The number of joints in the table.
+ * @return True if every joint's limits are in order, false otherwise.
+ */
+constexpr bool servo_joints_are_ordered(const ServoJoint *joints, int num_joints) {
+    return num_joints == 0 || (joints[0].limits_are_ordered() && servo_joints_are_ordered(joints + 1, num_joints - 1));
+}
+
+/**
+ * @brief Checks that every joint of a table sits at the index given by its ID. Meant for static_assert().
+ *
+ * @param joints The table of joints.
+ * @param num_joints The number of joints in the table.
+ * @param first_id The ID expected of the first joint (default: 0).
+ * @return True if the IDs count up from first_id, false otherwise.
+ */
+constexpr bool servo_joints_are_indexed(const ServoJoint *joints, int num_joints, int first_id = 0) {
+    return num_joints == 0 ||
+           (joints[0].id == first_id && servo_joints_are_indexed(joints + 1, num_joints - 1, first_id + 1));
+}
+
+/**
+ * @brief Checks that no joint of a table is connected to an address.
+ *
+ * @param address The board and channel to look for.
+ * @param joints The table of joints.
+ * @param num_joints The number of joints in the table.
+ * @return True if no joint uses the address, false otherwise.
+ */
+constexpr bool servo_joints_leave_unused(PwmAddress address, const ServoJoint *joints, int num_joints) {
+    return num_joints == 0 ||
+           ((joints[0].address.board != address.board || joints[0].address.channel != address.channel) &&
+            servo_joints_leave_unused(address, joints + 1, num_joints - 1));
+}
+
+/**
+ * @brief Checks that every joint of a table is connected to a board and channel that exist. Meant for static_assert().
+ *
+ * @param joints The table of joints.
+ * @param num_joints The number of joints in the table.
+ * @param num_boards The number of boards.
+ * @param num_channels The number of channels on each board.
+ * @return True if every joint's board and channel are in range, false otherwise.
+ */
+constexpr bool servo_joints_fit(const ServoJoint *joints, int num_joints, int num_boards, int num_channels) {
+    return num_joints == 0 || (joints[0].address.board < num_boards && joints[0].address.channel < num_channels &&
+                               servo_joints_fit(joints + 1, num_joints - 1, num_boards, num_channels));
+}
+
+/**
+ * @brief Checks that no two joints of a table share a board and channel. Meant for static_assert().
+ *
+ * @param joints The table of joints.
+ * @param num_joints The number of joints in the table.
+ * @return True if every joint has its own address, false otherwise.
+ */
+constexpr bool servo_joints_have_unique_addresses(const ServoJoint *joints, int num_joints) {
+    return num_joints == 0 || (servo_joints_leave_unused(joints[0].address, joints + 1, num_joints - 1) &&
+                               servo_joints_have_unique_addresses(joints + 1, num_joints - 1));
+}
+
+#endif // SERVO_JOINT_HPP
@@ -12,85 +12,75 @@
 #include "servo_keyframe.hpp"
 
 ServoKeyframe::ServoKeyframe(unsigned long duration_ms)
-    : _next(nullptr), _prev(nullptr), _servo_head(nullptr), _duration_ms(duration_ms), _track_index(-1),
+    : _channel_mask(0), _duration_ms(duration_ms), _next(nullptr), _prev(nullptr), _track_index(-1),
       _track_has_played(false), _dfmp3(nullptr) {
 }
 
-ServoKeyframe::ServoKeyframe(const ServoKeyframe &keyframe) {
-    _next = nullptr;
-    _prev = nullptr;
-    _servo_head = nullptr;
+ServoKeyframe::ServoKeyframe(const ServoKeyframe &keyframe) : _next(nullptr), _prev(nullptr) {
+    *this = keyframe;
+}
+
+ServoKeyframe &ServoKeyframe::operator=(const ServoKeyframe &keyframe) {
+    if (this == &keyframe) {
+        return *this;
+    }
     _dfmp3 = keyframe._dfmp3;
     _track_index = keyframe._track_index;
     _track_has_played = keyframe._track_has_played;
     _duration_ms = keyframe._duration_ms;
 
-    // Copy the linked list of servo_node elements
-    servo_node *current = keyframe._servo_head;
-    while (current != nullptr) {
-        add_servo_scalar(current->_servo, current->_target_scalar, current->_ramp_mode);
-        current = current->_next;
-    }
+    // Only the slots in use need copying
+    int num_slots = keyframe._num_slots();
+    _channel_mask = keyframe._channel_mask;
+    memcpy(_slot_servos, keyframe._slot_servos, num_slots * sizeof(_slot_servos[0]));
+    memcpy(_slot_targets, keyframe._slot_targets, num_slots * sizeof(_slot_targets[0]));
+    memcpy(_slot_durations_ms, keyframe._slot_durations_ms, num_slots * sizeof(_slot_durations_ms[0]));
+    memcpy(_slot_modes, keyframe._slot_modes, num_slots * sizeof(_slot_modes[0]));
+    return *this;
 }
 
-ServoKeyframe::~ServoKeyframe() {
-    // Delete the linked list of servo_node elements
-    servo_node *current = _servo_head;
-    while (current != nullptr) {
-        servo_node *next = current->_next;
-        delete current;
-        current = next;
-    }
+void ServoKeyframe::add_servo_angle(ServoMotor *servo, float angle, ramp_mode ramp_mode, unsigned long duration_ms) {
+    // Convert angle to a scalar and add the keyframe
+    add_servo_scalar(servo, servo->angle_to_scalar(angle), ramp_mode, duration_ms);
+}
 
-    // Stitch the ServoKeyframe linked list back together
-    if (_prev != nullptr) {
-        _prev->set_next(_next);
+void ServoKeyframe::add_servo_scalar(ServoMotor *servo, float scalar, ramp_mode ramp_mode, unsigned long duration_ms) {
+    uint32_t bit = _channel_bit(servo);
+    if (bit == 0) {
+        return;
     }
-    if (_next != nullptr) {
-        _next->set_prev(_prev);
+    int slot = __builtin_popcount(_channel_mask & (bit - 1));
+    if ((_channel_mask & bit) == 0) {
+        // Make room for the servo's slot, the slots stay in ID order
+        for (int i = _num_slots(); i > slot; i--) {
+            _slot_servos[i] = _slot_servos[i - 1];
+            _slot_targets[i] = _slot_targets[i - 1];
+            _slot_durations_ms[i] = _slot_durations_ms[i - 1];
+            _slot_modes[i] = _slot_modes[i - 1];
+        }
+        _channel_mask |= bit;
     }
+    // A servo that was already in the keyframe just gets its move updated
+    _slot_servos[slot] = servo;
+    _slot_targets[slot] = scalar;
+    _slot_durations_ms[slot] = duration_ms;
+    _slot_modes[slot] = (uint8_t)ramp_mode;
 }
 
-void ServoKeyframe::add_servo_angle(ServoMotor *servo, float angle, ramp_mode ramp_mode) {
-    // Convert angle to a scalar and add the keyframe
-    add_servo_scalar(servo, servo->angle_to_scalar(angle), ramp_mode);
-}
-
-void ServoKeyframe::add_servo_scalar(ServoMotor *servo, float scalar, ramp_mode ramp_mode) {
-    // Create the servo keyframe element and add it to the linked list
-    servo_node *new_servo_keyframe = new servo_node;
-    new_servo_keyframe->_servo = servo;
-    new_servo_keyframe->_target_scalar = scalar;
-    new_servo_keyframe->_ramp_mode = ramp_mode;
-    new_servo_keyframe->_next = nullptr;
-
-    // Find the end of the linked list and add the new keyframe
-    servo_node *current_servo = _servo_head;
-    if (current_servo == nullptr) {
-        _servo_head = new_servo_keyframe;
-    } else {
-        bool servo_exists = false;
-        while (current_servo != nullptr) {
-            // The given servo was already in the list, so update parameters
-            if (current_servo->_servo == servo) {
-                // If the given servo is already in the keyframe, update the scalar and ramp mode
-                current_servo->_target_scalar = scalar;
-                current_servo->_ramp_mode = ramp_mode;
-                servo_exists = true;
-                break;
-            }
-            // If this is the last servo in the list, break
-            if (current_servo->_next == nullptr) {
-                break;
-            }
-            current_servo = current_servo->_next;
-        }
-        if (!servo_exists) {
-            current_servo->_next = new_servo_keyframe;
-        } else {
-            delete new_servo_keyframe; // Delete the new keyframe as it's not needed
-        }
+bool ServoKeyframe::remove_servo(ServoMotor *servo) {
+    int slot = _find_slot(servo);
+    if (slot < 0) {
+        return false;
     }
+    int num_slots = _num_slots();
+    for (int i = slot; i < num_slots - 1; i++) {
+        _slot_servos[i] = _slot_servos[i + 1];
+        _slot_targets[i] = _slot_targets[i + 1];
+        _slot_durations_ms[i] = _slot_durations_ms[i + 1];
+        _slot_modes[i] = _slot_modes[i + 1];
+    }
+    _channel_mask &= ~_channel_bit(servo);
+    return true;
 }
 
 void ServoKeyframe::add_track(int track_index, DfMp3 *dfmp3) {
@@ -98,32 +88,164 @@ void ServoKeyframe::add_track(int track_index, DfMp3 *dfmp3) {
     _dfmp3 = dfmp3;
 }
 
-void ServoKeyframe::start_keyframe() {
+void ServoKeyframe::start_keyframe(unsigned long start_us) {
     _track_has_played = false;
-    // Iterate through the keyframe's servo keyframes and start them
-    servo_node *current = _servo_head;
-    while (current != nullptr) {
-        // Set the ramp mode for this servo
-        current->_servo->set_ramp_mode(current->_ramp_mode);
-        // Set the value to ramp to for this servo
-        current->_servo->set_scalar(current->_target_scalar, _duration_ms);
+    // Start every servo in the keyframe
+    int num_slots = _num_slots();
+    for (int slot = 0; slot < num_slots; slot++) {
+        _start_slot(slot, start_us);
+    }
+}
+
+bool ServoKeyframe::start_servo(ServoMotor *servo, unsigned long start_us) {
+    int slot = _find_slot(servo);
+    if (slot < 0) {
+        return false;
+    }
+    _start_slot(slot, start_us);
+    return true;
+}
+
+void ServoKeyframe::_start_slot(int slot, unsigned long start_us) {
+    ServoMotor *servo = _slot_servos[slot];
+    ramp_mode   mode = (ramp_mode)_slot_modes[slot];
+    // Set the ramp mode for this servo
+    servo->set_ramp_mode(mode);
+    // Set the value to ramp to for this servo
+    unsigned long duration_ms = _move_duration_ms(slot);
+    servo->set_scalar(_slot_targets[slot], duration_ms, start_us);
+    if (mode == CATMULL_ROM) {
+        servo->set_tangents(_spline_tangent_us(_prev, this, servo, duration_ms),
+                            _spline_tangent_us(this, _next, servo, duration_ms));
+    }
+}
+
+void ServoKeyframe::finish_keyframe() {
+    int num_slots = _num_slots();
+    for (int slot = 0; slot < num_slots; slot++) {
+        if (_move_duration_ms(slot) <= _duration_ms) {
+            _slot_servos[slot]->set_scalar(_slot_targets[slot], 0);
+        }
+    }
+}
+
+int ServoKeyframe::get_servos(ServoMotor **servos, int max_servos) const {
+    int num_servos = min(_num_slots(), max_servos);
+    memcpy(servos, _slot_servos, num_servos * sizeof(_slot_servos[0]));
+    return num_servos;
+}
+
+bool ServoKeyframe::get_servo_target(ServoMotor *servo, float *scalar, ramp_mode *mode,
+                                     unsigned long *duration_ms) const {
+    int slot = _find_slot(servo);
+    if (slot < 0) {
+        return false;
+    }
+    *scalar = _slot_targets[slot];
+    *mode = (ramp_mode)_slot_modes[slot];
+    if (duration_ms != nullptr) {
+        *duration_ms = _move_duration_ms(slot);
+    }
+    return true;
+}
+
+float ServoKeyframe::sample_servo_at(ServoMotor *servo, unsigned long elapsed_us, float start_scalar,
+                                     uint64_t progress_rate) const {
+    int           slot = _find_slot(servo);
+    ramp_mode     mode = (ramp_mode)_slot_modes[slot];
+    unsigned long duration_ms = _move_duration_ms(slot);
+    unsigned long duration_us = duration_ms * 1000UL;
+    // Ramp in pulse widths like ServoBank does, so the result matches playback to the microsecond
+    int target_us = servo->scalar_to_us(_slot_targets[slot]);
+    if (elapsed_us >= duration_us) {
+        return servo->us_to_scalar(target_us);
+    }
+    if (progress_rate == 0) {
+        progress_rate = q16_progress_rate(duration_us);
+    }
+    int   start_us = servo->scalar_to_us(start_scalar);
+    q16_t progress = q16_progress(elapsed_us, progress_rate);
+    int   us = start_us + q16_mul(target_us - start_us, ease_function(mode)(progress));
+    if (mode == CATMULL_ROM) {
+        int start_tangent_us = _spline_tangent_us(_prev, this, servo, duration_ms);
+        int end_tangent_us = _spline_tangent_us(this, _next, servo, duration_ms);
+        us += q16_mul(start_tangent_us, q16_hermite_h10(progress)) + q16_mul(end_tangent_us, q16_hermite_h11(progress));
+        us = servo->scalar_to_us(servo->us_to_scalar(us)); // Limited like ServoBank limits it
+    }
+    return servo->us_to_scalar(us);
+}
 
-        current = current->_next;
+uint64_t ServoKeyframe::get_servo_progress_rate(ServoMotor *servo) const {
+    unsigned long duration_us = _move_duration_ms(_find_slot(servo)) * 1000UL;
+    return duration_us != 0 ? q16_progress_rate(duration_us) : 0;
+}
+
+int ServoKeyframe::_spline_tangent_us(const ServoKeyframe *before, const ServoKeyframe *after, ServoMotor *servo,
+                                      unsigned long duration_ms) {
+    float         point_scalar, next_scalar, prev_scalar;
+    ramp_mode     before_mode, after_mode, prev_mode;
+    unsigned long before_ms, after_ms;
+    if (before == nullptr || after == nullptr ||
+        !before->get_servo_target(servo, &point_scalar, &before_mode, &before_ms) ||
+        !after->get_servo_target(servo, &next_scalar, &after_mode, &after_ms) || before_mode != CATMULL_ROM ||
+        after_mode != CATMULL_ROM) {
+        return 0;
+    }
+    // The spline only runs on through the point if the move before it ends just as the one after it starts
+    if (before_ms != before->_duration_ms) {
+        return 0;
     }
+
+    // The previous point is where the servo was when before started, its last target ahead of before
+    const ServoKeyframe *prev = before->_prev;
+    while (prev != nullptr && !prev->get_servo_target(servo, &prev_scalar, &prev_mode)) {
+        prev = prev->_prev;
+    }
+    unsigned long span_ms = before_ms + after_ms;
+    if (prev == nullptr || span_ms == 0) {
+        return 0;
+    }
+
+    // Catmull-Rom speed at the point, in microseconds per millisecond, times the length of the ramp
+    int prev_us = servo->scalar_to_us(prev_scalar);
+    int next_us = servo->scalar_to_us(next_scalar);
+    return (int)((int64_t)(next_us - prev_us) * (int64_t)duration_ms / (int64_t)span_ms);
+}
+
+uint32_t ServoKeyframe::_channel_bit(ServoMotor *servo) {
+    int id = servo->get_id();
+    return id >= 0 && id < MAX_SERVOS ? (uint32_t)1 << id : 0;
+}
+
+int ServoKeyframe::_find_slot(ServoMotor *servo) const {
+    uint32_t bit = _channel_bit(servo);
+    if ((_channel_mask & bit) == 0) {
+        return -1;
+    }
+    // The slots are packed in ID order, so there is one before this servo's for each servo with a lower ID
+    return __builtin_popcount(_channel_mask & (bit - 1));
+}
+
+int ServoKeyframe::_num_slots() const {
+    return __builtin_popcount(_channel_mask);
+}
+
+unsigned long ServoKeyframe::_move_duration_ms(int slot) const {
+    return _slot_durations_ms[slot] != 0 ? _slot_durations_ms[slot] : _duration_ms;
 }
 
 void ServoKeyframe::update() {
     // Check if the function has fired, if not, fire it
     if (_dfmp3 != nullptr && !_track_has_played) {
-        _dfmp3->playMp3FolderTrack(_track_index);
+        // Keyframes are updated from the motion task, so leave the actual serial traffic to loop()
+        TrackRequest::post(_dfmp3, _track_index);
         _track_has_played = true;
     }
-    // Iterate through the keyframe's servo keyframes and update them
-    servo_node *current = _servo_head;
-    while (current != nullptr) {
-        current->_servo->update();
-        current = current->_next;
-    }
+    // NOTE: The ramps started by start_keyframe() are advanced by the ServoBank
+}
+
+void ServoKeyframe::rewind_track() {
+    _track_has_played = false;
 }
 
 void ServoKeyframe::set_next(ServoKeyframe *next) {
@@ -157,99 +279,112 @@ std::string ServoKeyframe::serialize() const {
     // writing directly to SPIFFS. If this becomes a problem, we can change this to write directly to SPIFFS.
     std::string output_str;
     output_str += "duration_ms: " + std::to_string(_duration_ms) + "\n";
+    // Written once, before the servos, so a keyframe without servos keeps its sound
+    if (_dfmp3 != nullptr) {
+        output_str += "track_index: " + std::to_string(_track_index) + "\n";
+    }
     // Iterate through the keyframe's servo keyframes and serialize them
-    servo_node *current = _servo_head;
-    while (current != nullptr) {
-        output_str += "servo: " + current->_servo->get_name() + "\n";
-        output_str += "target_scalar: " + std::to_string(current->_target_scalar) + "\n";
-        output_str += "ramp_mode: " + std::to_string(current->_ramp_mode) + "\n";
-        if (_dfmp3 != nullptr) {
-            output_str += "track_index: " + std::to_string(_track_index) + "\n";
+    int num_slots = _num_slots();
+    for (int slot = 0; slot < num_slots; slot++) {
+        output_str += "servo: ";
+        output_str += _slot_servos[slot]->get_name();
+        output_str += "\n";
+        output_str += "target_scalar: " + std::to_string(_slot_targets[slot]) + "\n";
+        output_str += "ramp_mode: " + std::to_string(_slot_modes[slot]) + "\n";
+        if (_slot_durations_ms[slot] != 0) {
+            output_str += "servo_duration_ms: " + std::to_string(_slot_durations_ms[slot]) + "\n";
         }
-        current = current->_next;
     }
 
     return output_str;
 }
 
-ServoKeyframe *ServoKeyframe::deserialize(std::string keyframe_string, ServoContext &servo_context, DfMp3 *_dfmp3) {
+ServoKeyframe *ServoKeyframe::deserialize(const char *keyframe_string, ServoContext &servo_context, DfMp3 *_dfmp3) {
     // Creates a keyframe from the given string. Keyframes are stored as text data with the format:
     // duration_ms: <duration_ms>
+    // track_index: <track_index>
     //  servo: <servo_name0>
     //  target_scalar: <target_scalar0>
     //  ramp_mode: <ramp_mode0>
     //  servo: <servo_name1>
     //  target_scalar: <target_scalar1>
     //  ramp_mode: <ramp_mode1>
+    //  servo_duration_ms: <servo_duration_ms1>
     //  ...
+    // servo_duration_ms is left out when the move takes the keyframe's duration, which older files always do.
 
     ServoKeyframe *keyframe = new ServoKeyframe(0);
-    // Split the string into lines
-    std::istringstream keyframe_stream(keyframe_string);
-
-    unsigned long duration_ms;
-    struct ServoData {
-        std::string servo_name;
-        float       target_scalar;
-        ramp_mode   ramp_mode_;
-    };
-    std::vector<ServoData> servo_data;
-    for (std::string line; std::getline(keyframe_stream, line);) {
-        // Split the line into the key and value
-        std::istringstream line_stream(line);
-        std::string        key;
-        std::string        value;
-        std::getline(line_stream, key, ':');
-        std::getline(line_stream, value);
-
-        // Remove any leading or trailing whitespace
-        key.erase(0, key.find_first_not_of(" \t")); // Erase white space at the beginning
-        key.erase(key.find_last_not_of(" \t") + 1); // Erase white space at the end
-        value.erase(0, value.find_first_not_of(" \t"));
-        value.erase(value.find_last_not_of(" \t") + 1);
-
-        // Check the key and set the value
-        if (key == "duration_ms") {
-            // Get the duration of the new keyframe
-            duration_ms = std::stoul(value);
-            keyframe->set_duration(duration_ms);
-        } else if (key == "track_index") {
-            // Add a track to play at the start of the keyframe
-            keyframe->add_track(std::stoi(value), _dfmp3);
-        } else if (key == "servo") {
-            // New servo
-            servo_data.push_back(ServoData());
-            servo_data.back().servo_name = value;
-        } else if (key == "target_scalar") {
-            servo_data.back().target_scalar = std::stof(value);
-        } else if (key == "ramp_mode") {
-            servo_data.back().ramp_mode_ = static_cast<ramp_mode>(std::stoi(value));
+    ServoMotor    *servo = nullptr;
+    char           line[MAX_SERIALIZED_LINE];
+    while (*keyframe_string != '\0') {
+        // Copy out one line, a line too long for the buffer is cut short
+        size_t length = strcspn(keyframe_string, "\n");
+        size_t copied = min(length, sizeof(line) - 1);
+        memcpy(line, keyframe_string, copied);
+        line[copied] = '\0';
+        keyframe->deserialize_line(line, servo_context, _dfmp3, &servo);
+        keyframe_string += length;
+        if (*keyframe_string == '\n') {
+            keyframe_string++;
         }
     }
+    return keyframe;
+}
+
+void ServoKeyframe::deserialize_line(char *line, ServoContext &servo_context, DfMp3 *dfmp3, ServoMotor **servo) {
+    // Split the line into the key and value
+    char *value = strchr(line, ':');
+    if (value == nullptr) {
+        return;
+    }
+    *value++ = '\0';
+
+    // Remove any leading or trailing whitespace
+    char *key = line + strspn(line, " \t");
+    value += strspn(value, " \t");
+    for (char *end = value + strlen(value); end > value && isspace((unsigned char)end[-1]); end--) {
+        end[-1] = '\0';
+    }
+    for (char *end = key + strlen(key); end > key && isspace((unsigned char)end[-1]); end--) {
+        end[-1] = '\0';
+    }
 
-    // Add the servos to the keyframe
-    for (auto &data : servo_data) {
-        ServoMotor *servo = servo_context.map[data.servo_name];
-        if (servo == nullptr) {
+    // Check the key and set the value. A servo is added as soon as its name is read, the lines after it fill it in.
+    if (strcmp(key, "duration_ms") == 0) {
+        // Get the duration of the new keyframe
+        set_duration(strtoul(value, nullptr, 10));
+    } else if (strcmp(key, "track_index") == 0) {
+        // Add a track to play at the start of the keyframe
+        add_track(atoi(value), dfmp3);
+    } else if (strcmp(key, "servo") == 0) {
+        // New servo
+        *servo = servo_context.get(servo_context.find_id(value));
+        if (*servo == nullptr) {
             Serial.println("Servo not found");
-            continue;
+            return;
+        }
+        add_servo_scalar(*servo, 0.0f, QUADRATIC_INOUT, 0);
+    } else if (*servo != nullptr) {
+        int slot = _find_slot(*servo);
+        if (strcmp(key, "target_scalar") == 0) {
+            _slot_targets[slot] = strtof(value, nullptr);
+        } else if (strcmp(key, "ramp_mode") == 0) {
+            _slot_modes[slot] = (uint8_t)atoi(value);
+        } else if (strcmp(key, "servo_duration_ms") == 0) {
+            _slot_durations_ms[slot] = strtoul(value, nullptr, 10);
         }
-        keyframe->add_servo_scalar(servo, data.target_scalar, data.ramp_mode_);
     }
-
-    return keyframe;
 }
 
 void ServoKeyframe::print_servos() const {
     Serial.println("ServoKeyframe::print_servos()");
-    servo_node *current = _servo_head;
-    while (current != nullptr) {
+    int num_slots = _num_slots();
+    for (int slot = 0; slot < num_slots; slot++) {
         Serial.print("Servo: ");
-        Serial.println((unsigned int) current->_servo, HEX);
+        Serial.println((unsigned int) _slot_servos[slot], HEX);
         Serial.print("  ");
-        current->_servo->print_debug();
-        // Serial.println("  Target Scalar: " + String(current->_target_scalar));
-        // Serial.println("\t Ramp Mode: " + String(current->_ramp_mode));
-        current = current->_next;
+        _slot_servos[slot]->print_debug();
+        // Serial.println("  Target Scalar: " + String(_slot_targets[slot]));
+        // Serial.println("\t Ramp Mode: " + String(_slot_modes[slot]));
     }
 }
\ No newline at end of file
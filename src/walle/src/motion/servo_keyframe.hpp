@@ -14,32 +14,47 @@
 #ifndef SERVO_KEYFRAME_HPP
 #define SERVO_KEYFRAME_HPP
 
-#include <sstream>
 #include <string>
-#include <iostream>
 #include <Arduino.h>
-#include <Ramp.h>
-#include <vector>
+#include "easing.hpp"
 #include "servo_motor.hpp"
 #include "servo_context.hpp"
 #include "../audio/audio_player.hpp"
+#include "../audio/track_request.hpp"
 
 /**
  * @brief Represents a keyframe for controlling servo motors.
  * 
  * This class provides methods for adding servo angles and scalars, setting up ramps, and managing keyframe duration.
  * It also supports adding tracks to play at the start of the keyframe.
+ *
+ * A keyframe only holds the servos that start a move at it, so each servo's moves across an animation form a track of
+ * its own. A move lasts the keyframe's duration unless it is given one of its own, and a move longer than its keyframe
+ * keeps going through the keyframes after it until it ends or the servo's next move starts. A slow neck move can then
+ * run under several quick eye keyframes without being repeated in each of them.
  * The keyframe can be serialized and deserialized for storage or transmission.
+ *
+ * Each servo normally eases from rest to rest within its keyframe. A servo added with CATMULL_ROM is instead one
+ * segment of a Catmull-Rom spline through its targets, so over a run of back to back CATMULL_ROM keyframes it keeps
+ * moving through each target instead of stopping at it. The speed at a target is the distance between the targets on
+ * either side of it over the time between them. A servo is at rest at the ends of a run, after a keyframe that
+ * leaves it out and at its first target in the animation, since where it starts from isn't known until it plays.
+ *
+ * The servos are kept in fixed slots inside the keyframe, with no heap allocation. A bitmask has one bit per servo ID
+ * in the keyframe, and the slots hold the servos' moves packed in ID order, so the slot of a servo is the number of
+ * bits below its own. Finding a servo is then a mask and a popcount, and copying a keyframe is a plain copy.
  * 
  */
 class ServoKeyframe {
   public:
+    static const int MAX_SERVOS = ServoContext::MAX_SERVOS; ///< Maximum number of servos in a keyframe
+
     /**
      * @brief Constructs a ServoKeyframe object with the specified duration.
      * 
-     * @param duration_ms The duration of the keyframe in milliseconds.
+     * @param duration_ms The duration of the keyframe in milliseconds (default: 0).
      */
-    ServoKeyframe(unsigned long duration_ms);
+    ServoKeyframe(unsigned long duration_ms = 0);
 
     /**
      * @brief Copy constructor for ServoKeyframe objects. The copy constructor will not copy the next and previous
@@ -51,19 +66,25 @@ class ServoKeyframe {
     ServoKeyframe(const ServoKeyframe &keyframe);
 
     /**
-     * @brief Destructor for ServoKeyframe objects. Deletes this keyframe and stiches the linked list back together, if
-     * necessary.
+     * @brief Copy assignment. Copies the servos and track of the other keyframe, but not the next and previous
+     * pointers, which belong to where the keyframe is stored.
+     *
+     * @param keyframe The ServoKeyframe object to be copied.
+     * @return This keyframe.
      */
-    ~ServoKeyframe();
+    ServoKeyframe &operator=(const ServoKeyframe &keyframe);
 
     /**
-     * @brief Adds a servo the keyframe, final position defined by angle.
+     * @brief Adds a servo the keyframe, final position defined by angle. Adding a servo that is already in the keyframe
+     * replaces its move.
      * 
      * @param servo The ServoMotor object to control.
      * @param angle The target angle for the servo.
      * @param ramp_mode The ramp mode for the servo motion (default: QUADRATIC_INOUT).
+     * @param duration_ms The time the move takes in milliseconds, 0 for the keyframe's duration (default: 0).
      */
-    void add_servo_angle(ServoMotor *servo, float angle, ramp_mode ramp_mode = QUADRATIC_INOUT);
+    void add_servo_angle(ServoMotor *servo, float angle, ramp_mode ramp_mode = QUADRATIC_INOUT,
+                         unsigned long duration_ms = 0);
 
     /**
      * @brief Adds a servo to the keyframe, final position defined by scalar.
@@ -71,8 +92,18 @@ class ServoKeyframe {
      * @param servo The ServoMotor object to control.
      * @param scalar The target scalar for the servo.
      * @param ramp_mode The ramp mode for the servo motion (default: QUADRATIC_INOUT).
+     * @param duration_ms The time the move takes in milliseconds, 0 for the keyframe's duration (default: 0).
+     */
+    void add_servo_scalar(ServoMotor *servo, float scalar, ramp_mode ramp_mode = QUADRATIC_INOUT,
+                          unsigned long duration_ms = 0);
+
+    /**
+     * @brief Removes a servo from the keyframe, so it carries on with its previous move.
+     *
+     * @param servo The servo to remove.
+     * @return True if the servo was in the keyframe, false otherwise.
      */
-    void add_servo_scalar(ServoMotor *servo, float scalar, ramp_mode ramp_mode = QUADRATIC_INOUT);
+    bool remove_servo(ServoMotor *servo);
 
     /**
      * @brief Adds a track to play at the start of the keyframe.
@@ -84,16 +115,89 @@ class ServoKeyframe {
 
     /**
      * @brief Sets up the ramp for all the servos in this keyframe and starts them.
+     *
+     * @param start_us The micros() time the keyframe starts at on its animation's timeline. This is normally a little
+     * in the past, and the ramps are picked up part way through so they still end on time.
+     */
+    void start_keyframe(unsigned long start_us);
+
+    /**
+     * @brief Sets up and starts the ramp of one servo in this keyframe, like start_keyframe() does for every servo.
+     * Used to pick an animation up part way through, where a move may have started several keyframes back.
+     *
+     * @param servo The servo to start.
+     * @param start_us The micros() time the move starts at. The ramp starts from wherever the servo is now.
+     * @return True if the servo was started, false if it isn't in the keyframe.
      */
-    void start_keyframe();
+    bool start_servo(ServoMotor *servo, unsigned long start_us);
 
     /**
-     * @brief Updates the internal ramp state for all the servos in this keyframe.
+     * @brief Moves every servo whose move ends with this keyframe straight to its target. Called when the keyframe
+     * ends, so the next keyframe ramps from exactly these positions even if this one was passed over within one
+     * update. Longer moves are left to their ramps.
+     */
+    void finish_keyframe();
+
+    /**
+     * @brief Gets the servos this keyframe moves.
+     *
+     * @param[out] servos Filled with the servos, in order of servo ID.
+     * @param max_servos The size of servos.
+     * @return The number of servos written to servos.
+     */
+    int get_servos(ServoMotor **servos, int max_servos) const;
+
+    /**
+     * @brief Gets where this keyframe moves a servo and how.
+     *
+     * @param servo The servo to look for.
+     * @param[out] scalar The target scalar of the servo.
+     * @param[out] mode The ramp mode of the servo.
+     * @param[out] duration_ms The time the move takes in milliseconds, with the keyframe's duration filled in. Can be
+     * nullptr.
+     * @return True if the keyframe moves the servo, false otherwise. The outputs are only written if true.
+     */
+    bool get_servo_target(ServoMotor *servo, float *scalar, ramp_mode *mode,
+                          unsigned long *duration_ms = nullptr) const;
+
+    /**
+     * @brief Works out where a servo's move in this keyframe has it at a time into the keyframe, the same way playing
+     * it moves the servo, but without touching the servo.
+     *
+     * @param servo The servo, it has to be in the keyframe.
+     * @param elapsed_us The time since the keyframe started in microseconds. At or past the move's duration gives the
+     * target.
+     * @param start_scalar Where the servo is when the keyframe starts.
+     * @param progress_rate The move's get_servo_progress_rate(), or 0 to work it out. Passing it saves a 64-bit divide
+     * when the same move is sampled again and again.
+     * @return The scalar of the servo at elapsed_us.
+     */
+    float sample_servo_at(ServoMotor *servo, unsigned long elapsed_us, float start_scalar,
+                          uint64_t progress_rate = 0) const;
+
+    /**
+     * @brief Gets the q16_progress_rate() of a servo's move in this keyframe, see sample_servo_at().
+     *
+     * @param servo The servo, it has to be in the keyframe.
+     * @return The progress rate, 0 if the move takes no time.
+     */
+    uint64_t get_servo_progress_rate(ServoMotor *servo) const;
+
+    /**
+     * @brief Updates the keyframe, requesting its track the first time. The servos' ramps are advanced by their
+     * ServoBank.
      */
     void update();
+
+    /**
+     * @brief Lets the next update() request the keyframe's track again, without starting its ramps. Used when the
+     * keyframe is sampled instead of played.
+     */
+    void rewind_track();
     
     /**
-     * @brief Sets the duration of the keyframe.
+     * @brief Sets the duration of the keyframe. A baked animation holding the keyframe keeps playing its old frames
+     * until it is baked again.
      * 
      * @param duration_ms The duration of the keyframe in milliseconds.
      */
@@ -107,28 +211,28 @@ class ServoKeyframe {
     unsigned long get_duration();
 
     /**
-     * @brief Sets the next keyframe in the linked list.
+     * @brief Sets the keyframe after this one in its animation. Set by the ServoAnimation holding the keyframe.
      * 
-     * @param next The next ServoKeyframe object.
+     * @param next The next ServoKeyframe object, nullptr for the last keyframe.
      */
     void set_next(ServoKeyframe *next);
 
     /**
-     * @brief Gets the next keyframe in the linked list.
+     * @brief Gets the keyframe after this one in its animation.
      * 
      * @return The next ServoKeyframe object.
      */
     ServoKeyframe *get_next();
 
     /**
-     * @brief Sets the previous keyframe in the linked list.
+     * @brief Sets the keyframe before this one in its animation. Set by the ServoAnimation holding the keyframe.
      * 
-     * @param prev The previous ServoKeyframe object.
+     * @param prev The previous ServoKeyframe object, nullptr for the first keyframe.
      */
     void set_prev(ServoKeyframe *prev);
 
     /**
-     * @brief Gets the previous keyframe in the linked list.
+     * @brief Gets the keyframe before this one in its animation.
      * 
      * @return The previous ServoKeyframe object.
      */
@@ -149,7 +253,21 @@ class ServoKeyframe {
      * @param dfmp3 The DfMp3 object for playing tracks.
      * @return The deserialized ServoKeyframe object.
      */
-    static ServoKeyframe *deserialize(std::string keyframe_string, ServoContext& servo_context, DfMp3 *dfmp3);
+    static ServoKeyframe *deserialize(const char *keyframe_string, ServoContext& servo_context, DfMp3 *dfmp3);
+
+    /**
+     * @brief Reads one line of a serialized keyframe into this keyframe, without allocating. Feeding every line of a
+     * serialized keyframe to an empty keyframe gives the same keyframe as deserialize().
+     *
+     * @param line The line. Its newline and surrounding whitespace are ignored, and it is changed while it is parsed.
+     * @param servo_context The ServoContext object for servo management.
+     * @param dfmp3 The DfMp3 object for playing tracks.
+     * @param[in,out] servo The servo the lines after a servo line are for, nullptr before the first one. Start it at
+     * nullptr for each keyframe.
+     */
+    void deserialize_line(char *line, ServoContext &servo_context, DfMp3 *dfmp3, ServoMotor **servo);
+
+    static const int MAX_SERIALIZED_LINE = 80; ///< Longest line of a serialized keyframe, with its terminator
 
     /**
      * @brief Prints the servos in the keyframe for debugging purposes.
@@ -158,19 +276,52 @@ class ServoKeyframe {
 
   private:
     /**
-     * @brief Represents a node in the linked list of servos.
+     * @brief Works out the tangent of a servo's spline where one keyframe ends and the next starts.
+     *
+     * @param before The keyframe ending at the point, may be nullptr.
+     * @param after The keyframe starting at the point, may be nullptr.
+     * @param servo The servo.
+     * @param duration_ms The length of the ramp the tangent is for, the tangent is scaled to it.
+     * @return The tangent in microseconds over duration_ms, 0 unless both keyframes move the servo with CATMULL_ROM.
+     */
+    static int _spline_tangent_us(const ServoKeyframe *before, const ServoKeyframe *after, ServoMotor *servo,
+                                  unsigned long duration_ms);
+
+    /**
+     * @brief Gets the bit of a servo in the channel mask.
+     * @return The bit, 0 if the servo's ID can't be in a keyframe.
+     */
+    static uint32_t _channel_bit(ServoMotor *servo);
+
+    /**
+     * @brief Finds the slot of a servo.
+     * @return The slot, or -1 if the servo isn't in the keyframe.
+     */
+    int _find_slot(ServoMotor *servo) const;
+
+    /**
+     * @brief Gets the number of servos in the keyframe, which is the number of slots in use.
+     */
+    int _num_slots() const;
+
+    /**
+     * @brief Gets how long the move in a slot takes, with the keyframe's duration filled in.
+     */
+    unsigned long _move_duration_ms(int slot) const;
+
+    /**
+     * @brief Sets up the ramp of the move in a slot and starts it. See start_keyframe().
      */
-    struct servo_node {
-        ServoMotor *_servo;
-        float       _target_scalar;
-        ramp_mode   _ramp_mode;
-        servo_node *_next;
-    };
+    void _start_slot(int slot, unsigned long start_us);
 
-    servo_node *_servo_head; /**< The head of the linked list of servos. */
+    uint32_t      _channel_mask;                 /**< One bit per servo ID in the keyframe, bit 0 is ID 0. */
+    ServoMotor   *_slot_servos[MAX_SERVOS];      /**< The servo of each slot. */
+    float         _slot_targets[MAX_SERVOS];     /**< The target scalar of each slot. */
+    unsigned long _slot_durations_ms[MAX_SERVOS]; /**< The duration of each move, 0 follows the keyframe's duration. */
+    uint8_t       _slot_modes[MAX_SERVOS];       /**< The ramp_mode of each slot. */
     unsigned long _duration_ms; /**< The duration of the keyframe in milliseconds. */
-    ServoKeyframe *_next; /**< The next keyframe in the linked list. */
-    ServoKeyframe *_prev; /**< The previous keyframe in the linked list. */
+    ServoKeyframe *_next; /**< The next keyframe in the animation. */
+    ServoKeyframe *_prev; /**< The previous keyframe in the animation. */
     int _track_index; /**< The index of the track to play at the start of the keyframe. */
     bool _track_has_played; /**< Flag indicating whether the track has played. */
     DfMp3 *_dfmp3; /**< The DfMp3 object for playing tracks. */
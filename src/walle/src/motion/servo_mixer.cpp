@@ -0,0 +1,113 @@
+/**
+ * @file servo_mixer.cpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the implementation of the ServoMixer class, which mixes layers of servo positions into
+ * the pulse widths a ServoBank sends.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "servo_mixer.hpp"
+
+ServoMixer::ServoMixer(ServoBank *bank) : _bank(bank), _last_update_us(0), _fade_start_us(0), _fade_window_us(0) {
+    for (int layer = 0; layer < NUM_LAYERS; layer++) {
+        _masks[layer] = 0;
+        _weights[layer] = 0;
+        for (int id = 0; id < ServoBank::MAX_SERVOS; id++) {
+            _pose_us[layer][id] = 0;
+        }
+    }
+    for (int id = 0; id < ServoBank::MAX_SERVOS; id++) {
+        _speed_q16[id] = 0;
+        _fade_from_us[id] = 0;
+        _fade_speed_q16[id] = 0;
+    }
+}
+
+void ServoMixer::set_layer(Layer layer, ChannelMask mask, float weight) {
+    _masks[layer] = mask;
+    _weights[layer] = q16_from_float(constrain(weight, 0.0f, 1.0f));
+}
+
+ServoMixer::ChannelMask ServoMixer::get_active_mask(Layer layer) {
+    return _weights[layer] != 0 ? _masks[layer] : 0;
+}
+
+void ServoMixer::set_pose(Layer layer, const float *scalars) {
+    ChannelMask mask = _masks[layer];
+    for (int id = 0; id < _bank->get_num_servos(); id++) {
+        if (mask & channel(id)) {
+            _pose_us[layer][id] = _bank->scalar_to_us(id, scalars[id]);
+        }
+    }
+}
+
+void ServoMixer::start_crossfade(unsigned long now_us, unsigned long window_us) {
+    _fade_start_us = now_us;
+    _fade_window_us = window_us;
+    for (int id = 0; id < _bank->get_num_servos(); id++) {
+        _fade_from_us[id] = _bank->get_current_us(id);
+        _fade_speed_q16[id] = _speed_q16[id];
+    }
+}
+
+void ServoMixer::update(unsigned long now_us) {
+    _bank->update_ramps(now_us);
+
+    unsigned long dt_us = now_us - _last_update_us;
+    _last_update_us = now_us;
+    unsigned long fade_elapsed_us = now_us - _fade_start_us;
+    if (fade_elapsed_us >= _fade_window_us) {
+        _fade_window_us = 0;
+    }
+
+    ChannelMask mixed = 0;
+    for (int layer = 0; layer < NUM_LAYERS; layer++) {
+        mixed |= get_active_mask((Layer)layer);
+    }
+    ChannelMask animated = get_active_mask(ANIMATION);
+
+    // Only visit the servos some layer drives
+    for (int id = 0; id < _bank->get_num_servos() && (mixed >> id) != 0; id++) {
+        if (!(mixed & channel(id))) {
+            continue;
+        }
+        int last_us = _bank->get_current_us(id);
+        int out_us = last_us;
+        for (int layer = 0; layer < NUM_LAYERS; layer++) {
+            if (!(_masks[layer] & channel(id)) || _weights[layer] == 0) {
+                continue;
+            }
+            int layer_us = _pose_us[layer][id];
+            if (layer == ANIMATION) {
+                layer_us = _bank->get_ramp_us(id);
+                if (_fade_window_us != 0) {
+                    layer_us = _crossfade_us(id, layer_us, fade_elapsed_us);
+                }
+            }
+            out_us += q16_mul(layer_us - out_us, _weights[layer]);
+        }
+        _bank->set_output_us(id, out_us);
+        if (dt_us != 0) {
+            _speed_q16[id] = (int32_t)(((int64_t)(_bank->get_current_us(id) - last_us) << 16) / (int64_t)dt_us);
+        }
+        if (!(animated & channel(id))) {
+            _bank->set_us(id, _bank->get_current_us(id), 0); // Keep the idle ramp where the servo is
+        }
+    }
+
+    _bank->write_outputs();
+}
+
+int ServoMixer::_crossfade_us(int id, int ramp_us, unsigned long elapsed_us) {
+    // Where the servo would be if it carried on at its speed and slowed to a stop by the end of the window
+    q16_t   remaining = Q16_ONE - (q16_t)(((uint64_t)elapsed_us << 15) / _fade_window_us); // 1 - elapsed / 2 window
+    int64_t carried_us = ((int64_t)_fade_speed_q16[id] * (int64_t)elapsed_us) >> 16;
+    int     outgoing_us = _fade_from_us[id] + q16_mul((q16_t)carried_us, remaining);
+
+    // Ease into the ramp with the Hermite step, it is flat at both ends so the speed doesn't jump
+    q16_t progress = q16_progress(elapsed_us, q16_progress_rate(_fade_window_us));
+    return outgoing_us + q16_mul(ramp_us - outgoing_us, q16_hermite_h01(progress));
+}
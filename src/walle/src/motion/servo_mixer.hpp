@@ -0,0 +1,142 @@
+/**
+ * @file servo_mixer.hpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the declaration of the ServoMixer class, which mixes layers of servo positions, each with
+ * its own channel mask and weight, into the pulse widths a ServoBank sends.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef SERVO_MIXER_HPP
+#define SERVO_MIXER_HPP
+
+#include "easing.hpp"
+#include "servo_bank.hpp"
+#include <Arduino.h>
+
+/**
+ * @brief Mixes a stack of layers into the output of every servo in a ServoBank, once per tick.
+ *
+ * The layers are mixed in order, BASE first. Each layer has a mask of the servo IDs it drives and a weight, and moves
+ * the servos in its mask that far from the mix of the layers below it towards its own position. A weight of 1.0
+ * replaces them. The ANIMATION layer is the bank's ramps, where the ServoPlayer plays animations, and the other layers
+ * hold a pose set with set_pose(). So the head can play an animation while the operator keeps driving the arms, and
+ * the operator can take over a joint of the animation without stopping it.
+ *
+ * Only the servos in at least one layer's mask are mixed, the rest hold their last output. A servo the ANIMATION layer
+ * doesn't drive has its ramp moved to its output, so an animation that takes it over starts from where it really is.
+ *
+ * When one animation cuts into another, start_crossfade() blends the ANIMATION layer over from the old one. For the
+ * length of the window each servo carries on from its output at the speed it had, slowing to a stop, and the new
+ * animation's ramps are eased in over it with a curve that starts and ends flat, so the speed has no step at either
+ * end. It only needs the outputs and speeds the mixer already keeps, so nothing is allocated.
+ *
+ * NOTE: Like the bank, the mixer is owned by the motion task.
+ */
+class ServoMixer {
+  public:
+    /**
+     * @brief The layers, in the order they are mixed.
+     */
+    enum Layer {
+        BASE,      ///< The pose everything else is mixed over
+        ANIMATION, ///< The bank's ramps
+        MANUAL,    ///< Manual control that overrides the animation
+        NUM_LAYERS
+    };
+
+    typedef uint32_t ChannelMask; ///< One bit per servo ID, bit 0 is ID 0
+
+    static const ChannelMask ALL_CHANNELS = 0xFFFFFFFFUL; ///< Every servo
+
+    /**
+     * @brief Gets the mask bit of a servo.
+     *
+     * @param id The ID of the servo.
+     * @return The mask with only that servo in it.
+     */
+    static ChannelMask channel(int id) {
+        return (ChannelMask)1 << id;
+    }
+
+    /**
+     * @brief Constructs a ServoMixer for a bank. Every layer starts with an empty mask.
+     *
+     * @param bank The bank to mix the outputs of.
+     */
+    ServoMixer(ServoBank *bank);
+
+    /**
+     * @brief Sets which servos a layer drives and how strongly.
+     *
+     * @param layer The layer.
+     * @param mask The servos the layer drives.
+     * @param weight How far the layer moves its servos from the layers below it, from 0.0 to 1.0.
+     */
+    void set_layer(Layer layer, ChannelMask mask, float weight);
+
+    /**
+     * @brief Gets which servos a layer drives, if its weight isn't 0.
+     *
+     * @param layer The layer.
+     * @return The layer's mask, or 0 if its weight is 0.
+     */
+    ChannelMask get_active_mask(Layer layer);
+
+    /**
+     * @brief Sets the pose of a layer. Doesn't apply to the ANIMATION layer, which follows the bank's ramps.
+     *
+     * @param layer The layer.
+     * @param scalars One scalar per servo ID, -1.0 is min_us and 1.0 is max_us. Only the servos in the layer's mask are
+     * read.
+     */
+    void set_pose(Layer layer, const float *scalars);
+
+    /**
+     * @brief Starts blending the ANIMATION layer from where the servos are heading into the bank's ramps. Call it when
+     * a new animation replaces a running one, before the next update().
+     *
+     * @param now_us The current micros() time, the start of the window.
+     * @param window_us The length of the blend in microseconds. 0 cancels a blend.
+     */
+    void start_crossfade(unsigned long now_us, unsigned long window_us);
+
+    /**
+     * @brief Advances the bank's ramps, mixes the layers and writes the outputs that changed.
+     *
+     * @param now_us The current micros() time, the same one the animations are updated with.
+     */
+    void update(unsigned long now_us);
+
+  private:
+    static_assert(ServoBank::MAX_SERVOS <= 32, "A ChannelMask holds one bit per servo");
+
+    /**
+     * @brief Blends a servo's ramp with where the servo would have gone without the new animation.
+     *
+     * @param id The ID of the servo.
+     * @param ramp_us The servo's ramp, the new animation.
+     * @param elapsed_us The time since the crossfade started, less than the window.
+     * @return The blended pulse width in microseconds.
+     */
+    int _crossfade_us(int id, int ramp_us, unsigned long elapsed_us);
+
+    ServoBank  *_bank;                                      /**< The bank whose outputs are mixed. */
+    ChannelMask _masks[NUM_LAYERS];                         /**< The servos each layer drives. */
+    q16_t       _weights[NUM_LAYERS];                       /**< The weight of each layer in Q16. */
+    int         _pose_us[NUM_LAYERS][ServoBank::MAX_SERVOS]; /**< The pose of each layer. Unused for ANIMATION. */
+
+    // Speeds
+    unsigned long _last_update_us;                      /**< The time of the last update(). */
+    int32_t       _speed_q16[ServoBank::MAX_SERVOS];    /**< Output speed over the last update in us per us, Q16. */
+
+    // Crossfade
+    unsigned long _fade_start_us;                       /**< The time the crossfade started. */
+    unsigned long _fade_window_us;                      /**< The length of the crossfade, 0 if there isn't one. */
+    int           _fade_from_us[ServoBank::MAX_SERVOS]; /**< Each servo's output when the crossfade started. */
+    int32_t       _fade_speed_q16[ServoBank::MAX_SERVOS]; /**< Each servo's speed when the crossfade started. */
+};
+
+#endif // SERVO_MIXER_HPP
@@ -4,135 +4,99 @@
  * @brief This file contains the implementation of the ServoMotor class, which is used to control a servo motor.
  * @version 0.1
  * @date 2024-02-19
- * 
+ *
  * @copyright Copyright (c) 2024
- * 
+ *
  */
 #include "servo_motor.hpp"
+#include "servo_bank.hpp"
 
-ServoMotor::ServoMotor(Adafruit_PWMServoDriver *pca9685, int pin, std::string name, int neutral_us, int min_us, int max_us,
-                       float min_angle_deg, float max_angle_deg, float neutral_angle_deg)
-    : Motor(pca9685, pin, name, neutral_us, min_us, max_us), _min_angle_deg(min_angle_deg), _max_angle_deg(max_angle_deg),
-      _neutral_angle_deg(neutral_angle_deg) {
-    // Calculate the slope and intercept for the angle to us mapping
-    _angle_positive_to_us_slope = (float)(_max_us - _neutral_us) / (_max_angle_deg - _neutral_angle_deg);
-    _angle_negative_to_us_slope = (float)(_neutral_us - _min_us) / (_neutral_angle_deg - _min_angle_deg);
-    _target_us = _neutral_us;
-    _us_ramp = rampInt();
-    _ramp_mode = QUADRATIC_INOUT;
+ServoMotor::ServoMotor() : _bank(nullptr), _id(-1) {
 }
 
-void  ServoMotor::set_min_us(int min_us) {
-    // Set minimum us, recalculate slope for asymetric mapping
-    Motor::set_min_us(min_us);
-    _angle_negative_to_us_slope = (float)(_neutral_us - _min_us) / (_neutral_angle_deg - _min_angle_deg);
-}
-void  ServoMotor::set_max_us(int max_us) {
-    // Update max us and its slope
-    Motor::set_max_us(max_us);
-    _angle_positive_to_us_slope = (float)(_max_us - _neutral_us) / (_max_angle_deg - _neutral_angle_deg);
-}
-void  ServoMotor::set_neutral_us(int neutral_us) {
-    // Update neutral us and slopes
-    Motor::set_neutral_us(neutral_us);
-    _angle_positive_to_us_slope = (float)(_max_us - _neutral_us) / (_max_angle_deg - _neutral_angle_deg);
-    _angle_negative_to_us_slope = (float)(_neutral_us - _min_us) / (_neutral_angle_deg - _min_angle_deg);
+ServoMotor::ServoMotor(ServoBank *bank, int id) : _bank(bank), _id(id) {
 }
 
 void ServoMotor::set_angle(float angle, unsigned long time_ms) {
-    // Convert target angle to target us, then set up the ramp
-    _target_us = angle_to_us(angle);
-    _us_ramp.go(_target_us, time_ms, _ramp_mode);
+    _bank->set_angle(_id, angle, time_ms);
 }
 
-void ServoMotor::set_min_angle(float min_angle_deg) {
-    // Set minimum angle, recalculate slope for asymetric mapping
-    _min_angle_deg = min_angle_deg;
-    _angle_negative_to_us_slope = (float)(_neutral_us - _min_us) / (_neutral_angle_deg - _min_angle_deg);
+void ServoMotor::set_scalar(float scalar, unsigned long time_ms) {
+    _bank->set_scalar(_id, scalar, time_ms);
 }
 
-void ServoMotor::set_max_angle(float max_angle_deg) {
-    // Update max angle and its slope
-    _max_angle_deg = max_angle_deg;
-    _angle_positive_to_us_slope = (float)(_max_us - _neutral_us) / (_max_angle_deg - _neutral_angle_deg);
-
+void ServoMotor::set_scalar(float scalar, unsigned long time_ms, unsigned long start_us) {
+    _bank->set_scalar(_id, scalar, time_ms, start_us);
 }
 
-void ServoMotor::set_neutral_angle(float neutral_angle_deg) {
-    // Update neutral angle and slopes
-    _neutral_angle_deg = neutral_angle_deg;
-    _angle_positive_to_us_slope = (float)(_max_us - _neutral_us) / (_max_angle_deg - _neutral_angle_deg);
-    _angle_negative_to_us_slope = (float)(_neutral_us - _min_us) / (_neutral_angle_deg - _min_angle_deg);
+void ServoMotor::set_us(int us, unsigned long time_ms) {
+    _bank->set_us(_id, us, time_ms);
 }
 
-void ServoMotor::set_scalar(float scalar, unsigned long time_ms) {
-    // Set the speed as a scaller from -1.0 to 1.0. -1.0 is min_us, 1.0 is max_us.
-    _target_us = _scalar_to_us(scalar);
-    _us_ramp.go(_target_us, time_ms, _ramp_mode);
+void ServoMotor::set_tangents(int start_tangent_us, int end_tangent_us) {
+    _bank->set_tangents(_id, start_tangent_us, end_tangent_us);
 }
 
 void ServoMotor::set_ramp_mode(ramp_mode mode) {
-    _ramp_mode = mode;
+    _bank->set_ramp_mode(_id, mode);
 }
 
-void ServoMotor::update() {
-    // Update the ramp and set the motor to the current us
-    _current_us = _us_ramp.update();
-    Motor::update();
+int ServoMotor::get_current_us() {
+    return _bank->get_current_us(_id);
 }
 
 float ServoMotor::get_angle() {
-    return us_to_angle(_current_us);
+    return _bank->us_to_angle(_id, _bank->get_current_us(_id));
 }
 
 float ServoMotor::get_scalar() {
-    return us_to_scalar(_current_us);
+    return _bank->us_to_scalar(_id, _bank->get_current_us(_id));
+}
+
+float ServoMotor::get_current_scalar() {
+    return get_scalar();
 }
 
 float ServoMotor::angle_to_scalar(float angle_deg) {
-    // Convert the given angle to the corresponding scalar, accounting for asymetric mapping
-    if (angle_deg > _neutral_angle_deg) {
-        return (float)(angle_deg - _neutral_angle_deg) / (_max_angle_deg - _neutral_angle_deg);
-    } else {
-        return (float)(angle_deg - _neutral_angle_deg) / (_neutral_angle_deg - _min_angle_deg);
-    }
+    return _bank->angle_to_scalar(_id, angle_deg);
 }
 
 float ServoMotor::us_to_angle(int us) {
-    // Returns the closest the angle corresponding to the given us
-    if (us > _neutral_us) {
-        return (float)(us - _neutral_us) / _angle_positive_to_us_slope + _neutral_angle_deg;
-    } else {
-        return (float)(us - _neutral_us) / _angle_negative_to_us_slope + _neutral_angle_deg;
-    }
+    return _bank->us_to_angle(_id, us);
 }
 
 float ServoMotor::us_to_scalar(int us) {
-    // Returns the scalar corresponding to the given us
-    if (us > _neutral_us) {
-        return (float)(us - _neutral_us) / (_max_us - _neutral_us);
-    } else {
-        return (float)(us - _neutral_us) / (_neutral_us - _min_us);
-    }
+    return _bank->us_to_scalar(_id, us);
+}
+
+int ServoMotor::scalar_to_us(float scalar) {
+    return _bank->scalar_to_us(_id, scalar);
 }
 
 float ServoMotor::angle_to_us(float angle_deg) {
-    // Converts the given angle to the corresponding us, accounting for asymetric mapping
-    if (angle_deg > _neutral_angle_deg) {
-        return (float)(angle_deg - _neutral_angle_deg) * _angle_positive_to_us_slope + _neutral_us;
-    } else {
-        return (float)(angle_deg - _neutral_angle_deg) * _angle_negative_to_us_slope + _neutral_us;
-    }
+    return _bank->angle_to_us(_id, angle_deg);
+}
+
+const char *ServoMotor::get_name() {
+    return _bank->get_name(_id);
+}
+
+PwmAddress ServoMotor::get_address() {
+    return _bank->get_address(_id);
+}
+
+int ServoMotor::get_id() {
+    return _id;
 }
 
 void ServoMotor::print_debug() {
     // Print the servo's parameters
     Serial.print("Servo: ");
-    Serial.print(_name.c_str());
+    Serial.print(get_name());
     Serial.print(" | Angle: ");
     Serial.print(get_angle());
     Serial.print(" | Scalar: ");
     Serial.print(get_scalar());
     Serial.print(" | us: ");
-    Serial.println(_current_us);
+    Serial.println(get_current_us());
 }
@@ -10,7 +10,12 @@
  */
 #include "servo_player.hpp"
 
-ServoPlayer::ServoPlayer() : _current_animation(nullptr), _is_playing(false) {
+ServoPlayer::ServoPlayer()
+    : _current_animation(nullptr), _is_playing(false), _carried_us(0), _max_lateness_us(0), _channel_mask(0),
+      _crossfade_pending(false), _start_pending(false), _play_requested_us(0), _start_latency_us(0),
+      _max_start_latency_us(0), _queue(), _queue_head(0), _queue_length(0), _current_entry(), _current_queued(false),
+      _shuffle(false), _repeat(false), _shuffle_state(1) {
+    _mutex = xSemaphoreCreateMutex();
 }
 
 ServoPlayer& ServoPlayer::getInstance() {
@@ -19,39 +24,221 @@ ServoPlayer& ServoPlayer::getInstance() {
     return instance;
 }
 
-void ServoPlayer::play(ServoAnimation *animation) {
-    stop();
-    // Play the animation
-    _current_animation = animation;
-    if (_current_animation != nullptr) {
-        _current_animation->play();
-        _is_playing = true;
+void ServoPlayer::play(ServoAnimation *animation, float rate, ServoAnimation::PlaybackMode mode,
+                       unsigned int passes) {
+    unsigned long requested_us = micros();
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    bool interrupted = _is_playing;
+    uint32_t old_mask = interrupted ? _channel_mask.load() : 0;
+    _stop();
+    // Play the animation. The servos of an animation it cuts off stay in the mask so they can be faded out.
+    if (animation != nullptr) {
+        _start({animation, rate, mode, passes}, old_mask);
+        _current_queued = false;
+        _crossfade_pending = interrupted;
+        _start_pending = true;
+        _play_requested_us = requested_us;
     }
+    xSemaphoreGive(_mutex);
 }
 
 void ServoPlayer::stop() {
-    // Stop the current animation
-    if (_current_animation != nullptr) {
-        _current_animation->stop();
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _stop();
+    _queue_length = 0;
+    xSemaphoreGive(_mutex);
+}
+
+bool ServoPlayer::enqueue(ServoAnimation *animation, float rate, ServoAnimation::PlaybackMode mode,
+                          unsigned int passes) {
+    if (animation == nullptr) {
+        return false;
     }
-    _current_animation = nullptr;
-    _is_playing = false;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    bool queued = _queue_length < QUEUE_CAPACITY;
+    if (queued) {
+        _queue[(_queue_head + _queue_length) % QUEUE_CAPACITY] = {animation, rate, mode, passes};
+        _queue_length++;
+        if (!_is_playing) {
+            _startNext();
+        }
+    }
+    xSemaphoreGive(_mutex);
+    return queued;
+}
+
+void ServoPlayer::clearQueue() {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _queue_length = 0;
+    xSemaphoreGive(_mutex);
+}
+
+void ServoPlayer::forget(ServoAnimation *animation) {
+    if (animation == nullptr) {
+        return;
+    }
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (_current_animation == animation) {
+        _stop();
+    }
+    // Close up the queue over the dropped entries
+    int kept = 0;
+    for (int i = 0; i < _queue_length; i++) {
+        const QueueEntry &entry = _queue[(_queue_head + i) % QUEUE_CAPACITY];
+        if (entry.animation != animation) {
+            _queue[(_queue_head + kept++) % QUEUE_CAPACITY] = entry;
+        }
+    }
+    _queue_length = kept;
+    xSemaphoreGive(_mutex);
+}
+
+int ServoPlayer::getQueueLength() {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    int length = _queue_length;
+    xSemaphoreGive(_mutex);
+    return length;
+}
+
+void ServoPlayer::setShuffle(bool shuffle, uint32_t seed) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _shuffle = shuffle;
+    _shuffle_state = seed != 0 ? seed : 1; // xorshift never leaves 0
+    xSemaphoreGive(_mutex);
+}
+
+void ServoPlayer::setRepeat(bool repeat) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _repeat = repeat;
+    xSemaphoreGive(_mutex);
+}
+
+bool ServoPlayer::seek(unsigned long t_us) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    bool seeking = _is_playing && _current_animation->seek(t_us);
+    xSemaphoreGive(_mutex);
+    return seeking;
+}
+
+bool ServoPlayer::seekKeyframe(int index) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    bool seeking = _is_playing && _current_animation->seek_keyframe(index);
+    xSemaphoreGive(_mutex);
+    return seeking;
 }
 
 bool ServoPlayer::isPlaying() {
     return _is_playing;
 }
 
-void ServoPlayer::update() {
+void ServoPlayer::update(unsigned long now_us) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
     // Update the current animation
     if (_is_playing && _current_animation != nullptr) {
-        _current_animation->update();
+        if (_start_pending) {
+            // now_us can be from just before play() took the mutex, so don't let the latency go negative
+            long latency_us = (long)(now_us - _play_requested_us);
+            _start_latency_us = latency_us > 0 ? latency_us : 0;
+            if (_start_latency_us > _max_start_latency_us) {
+                _max_start_latency_us = _start_latency_us.load();
+            }
+            _start_pending = false;
+        }
+        _current_animation->update(now_us);
+        if (_current_animation->take_discontinuity()) {
+            _crossfade_pending = true;
+        }
+        // Hand over to the next queued animation on this tick, starting it when the last one ended. An animation that
+        // ends within the tick hands over again, up to one round of the queue.
+        for (int i = 0; i <= QUEUE_CAPACITY && !_current_animation->isPlaying(); i++) {
+            unsigned long end_us = _current_animation->get_end_us();
+            if (!_startNext()) {
+                break;
+            }
+            _current_animation->start_timeline_at(end_us);
+            _current_animation->update(now_us);
+        }
+        _carried_us = _current_animation->get_carried_us();
+        _max_lateness_us = _current_animation->get_max_lateness_us();
         if (!_current_animation->isPlaying()) {
-            stop();
+            _stop();
         }
     }
+    xSemaphoreGive(_mutex);
+}
+
+uint32_t ServoPlayer::getCarriedUs() {
+    return _carried_us;
+}
+
+uint32_t ServoPlayer::getMaxLatenessUs() {
+    return _max_lateness_us;
+}
+
+uint32_t ServoPlayer::getChannelMask() {
+    return _channel_mask;
+}
+
+bool ServoPlayer::takeCrossfade() {
+    return _crossfade_pending.exchange(false);
+}
+
+uint32_t ServoPlayer::getStartLatencyUs() {
+    return _start_latency_us;
+}
+
+uint32_t ServoPlayer::getMaxStartLatencyUs() {
+    return _max_start_latency_us;
 }
 
 ServoAnimation *ServoPlayer::getCurrentAnimation() {
     return _current_animation;
 }
+
+void ServoPlayer::_start(const QueueEntry &entry, uint32_t keep_mask) {
+    _current_entry = entry;
+    _current_animation = entry.animation;
+    _channel_mask = _current_animation->get_channel_mask() | keep_mask;
+    _current_animation->play(entry.rate, entry.mode, entry.passes);
+    _is_playing = true;
+}
+
+bool ServoPlayer::_startNext() {
+    if (_repeat && _current_queued && _queue_length < QUEUE_CAPACITY) {
+        _queue[(_queue_head + _queue_length) % QUEUE_CAPACITY] = _current_entry;
+        _queue_length++;
+    }
+    _current_queued = false;
+    if (_queue_length == 0) {
+        return false;
+    }
+
+    if (_shuffle) {
+        // Swap a random entry to the head. xorshift32, so the order only depends on the seed.
+        _shuffle_state ^= _shuffle_state << 13;
+        _shuffle_state ^= _shuffle_state >> 17;
+        _shuffle_state ^= _shuffle_state << 5;
+        int pick = (_queue_head + _shuffle_state % _queue_length) % QUEUE_CAPACITY;
+        QueueEntry picked = _queue[pick];
+        _queue[pick] = _queue[_queue_head];
+        _queue[_queue_head] = picked;
+    }
+    QueueEntry entry = _queue[_queue_head];
+    _queue_head = (_queue_head + 1) % QUEUE_CAPACITY;
+    _queue_length--;
+
+    // The servos of the animation before hold its last pose, keep them until loop() has read it back
+    _start(entry, _is_playing ? _channel_mask.load() : 0);
+    _current_queued = true;
+    return true;
+}
+
+void ServoPlayer::_stop() {
+    // Stop the current animation
+    if (_current_animation != nullptr) {
+        _current_animation->stop();
+    }
+    _current_animation = nullptr;
+    _is_playing = false;
+    _current_queued = false; // Repeat mustn't queue a stopped animation again
+}
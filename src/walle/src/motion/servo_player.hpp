@@ -12,6 +12,8 @@
 #ifndef SERVO_PLAYER_H
 #define SERVO_PLAYER_H
 
+#include <Arduino.h>
+#include <atomic>
 #include "animate_servo.hpp"
 
 /**
@@ -21,9 +23,27 @@
  * The ServoPlayer class provides functionality to play, stop, update, and retrieve information about servo animations.
  * It follows the singleton design pattern to ensure that only one instance of the class can exist.
  * The copy constructor and assignment operator are deleted to prevent unintended copying of the class.
+ *
+ * play(), stop() and update() are guarded by a mutex so animations can be started and stopped from loop() while the
+ * motion task updates them. Once stop() returns, update() is no longer touching the old animation and it is safe to
+ * delete it.
+ *
+ * Playing an animation while another one plays cuts the old one off where it is. The player then keeps the old
+ * animation's servos in its channel mask, so they finish the move they were on instead of being dropped mid-ramp, and
+ * flags a crossfade for the motion task to start on the ServoMixer with takeCrossfade(). So does an animation that
+ * jumps, like one played in reverse.
+ *
+ * Animations can also be queued with enqueue(). The queue is a fixed ring of QUEUE_CAPACITY entries, so it never
+ * allocates. When an animation ends, update() starts the next one on the same tick, with its timeline starting at the
+ * time the last one ended rather than at the tick. A show of queued animations then runs for exactly the sum of their
+ * lengths, with no gap and no drift however late the ticks are. Each entry has its own rate, mode and passes. The
+ * queue can be shuffled with a seeded generator, so a shuffled show plays the same order every time for the same
+ * seed, and repeated, which puts each animation back at the end of the queue when it finishes.
  */
 class ServoPlayer {
 public:
+    static const int QUEUE_CAPACITY = 16; ///< Maximum number of animations waiting in the queue
+
     // Delete the copy constructor and assignment operator
     ServoPlayer(const ServoPlayer&) = delete;
     ServoPlayer& operator=(const ServoPlayer&) = delete;
@@ -37,14 +57,76 @@ public:
     /**
      * @brief Play a servo animation.
      * @param animation The servo animation to play.
+     * @param rate The playback rate, see ServoAnimation::play(). Negative plays in reverse.
+     * @param mode What the animation does when it gets to the end.
+     * @param passes The number of passes for a looping mode, 0 loops until stopped.
      */
-    void play(ServoAnimation* animation);
+    void play(ServoAnimation* animation, float rate = 1.0f,
+              ServoAnimation::PlaybackMode mode = ServoAnimation::ONCE, unsigned int passes = 0);
 
     /**
-     * @brief Stop the currently playing servo animation.
+     * @brief Stop the currently playing servo animation and clear the queue.
      */
     void stop();
 
+    /**
+     * @brief Add an animation to the end of the queue. It starts right away if nothing is playing, otherwise as soon
+     * as the animations before it end.
+     * @param animation The servo animation to play. It has to stay alive until it has played or the queue is cleared,
+     * call forget() before deleting it.
+     * @param rate The playback rate, see ServoAnimation::play(). Negative plays in reverse.
+     * @param mode What the animation does when it gets to the end.
+     * @param passes The number of passes for a looping mode. 0 loops until stopped, which holds up the queue.
+     * @return True if the animation was queued, false if the queue is full or animation is nullptr.
+     */
+    bool enqueue(ServoAnimation* animation, float rate = 1.0f,
+                 ServoAnimation::PlaybackMode mode = ServoAnimation::ONCE, unsigned int passes = 0);
+
+    /**
+     * @brief Remove every animation from the queue. The playing animation carries on.
+     */
+    void clearQueue();
+
+    /**
+     * @brief Drop every reference to an animation, so it can be deleted. Stops it if it is playing and removes each of
+     * its queue entries, the rest of the queue keeps its order.
+     * @param animation The animation, nullptr does nothing.
+     */
+    void forget(ServoAnimation* animation);
+
+    /**
+     * @brief Get the number of animations waiting in the queue.
+     * @return The number of queued animations, not counting the playing one.
+     */
+    int getQueueLength();
+
+    /**
+     * @brief Pick the next animation from the queue at random instead of in order.
+     * @param shuffle True to shuffle.
+     * @param seed The seed of the generator. The same seed and queue always give the same order.
+     */
+    void setShuffle(bool shuffle, uint32_t seed = 1);
+
+    /**
+     * @brief Put each queued animation back at the end of the queue when it finishes, so the queue plays as a loop.
+     * @param repeat True to repeat the queue.
+     */
+    void setRepeat(bool repeat);
+
+    /**
+     * @brief Jump the playing animation to a time into it. See ServoAnimation::seek().
+     * @param t_us The time into the animation in microseconds.
+     * @return True if the animation will jump, false if nothing is playing or t_us is past its end.
+     */
+    bool seek(unsigned long t_us);
+
+    /**
+     * @brief Jump the playing animation to the start of a keyframe. See ServoAnimation::seek_keyframe().
+     * @param index The number of the keyframe, 0 is the head.
+     * @return True if the animation will jump, false if nothing is playing or there is no such keyframe.
+     */
+    bool seekKeyframe(int index);
+
     /**
      * @brief Check if a servo animation is currently playing.
      * @return True if a servo animation is playing, false otherwise.
@@ -56,8 +138,48 @@ public:
      * 
      * This method should be called periodically to update the servo player's state.
      * It is responsible for advancing the animation frames and controlling the servos accordingly.
+     * @param now_us The current micros() time, the same one the ServoBank is updated with.
+     */
+    void update(unsigned long now_us);
+
+    /**
+     * @brief Get the timing error the current or last animation carried into its later keyframes. Safe to call from
+     * any task.
+     * @return The total lateness of the animation's keyframe ends in microseconds.
      */
-    void update();
+    uint32_t getCarriedUs();
+
+    /**
+     * @brief Get the latest the current or last animation noticed a keyframe end. Safe to call from any task.
+     * @return The largest timing error of a single keyframe in microseconds.
+     */
+    uint32_t getMaxLatenessUs();
+
+    /**
+     * @brief Get the servos the current or last animation moves. Safe to call from any task.
+     * @return One bit per servo ID, the layout of a ServoMixer::ChannelMask. 0 if nothing has been played.
+     */
+    uint32_t getChannelMask();
+
+    /**
+     * @brief Check whether play() cut into a running animation or the animation jumped since the last call, and clear
+     * the flag. Called by the motion task before it mixes the outputs, to start a crossfade.
+     * @return True if the servos should be crossfaded into the new animation.
+     */
+    bool takeCrossfade();
+
+    /**
+     * @brief Get the time from the last play() call to the update that first moved its animation. Safe to call from
+     * any task.
+     * @return The start latency in microseconds.
+     */
+    uint32_t getStartLatencyUs();
+
+    /**
+     * @brief Get the longest start latency since boot. Safe to call from any task.
+     * @return The longest start latency in microseconds.
+     */
+    uint32_t getMaxStartLatencyUs();
 
     /**
      * @brief Get the currently playing servo animation.
@@ -71,8 +193,55 @@ private:
      */
     ServoPlayer();
 
+    /**
+     * @brief An animation and how to play it.
+     */
+    struct QueueEntry {
+        ServoAnimation *animation;         ///< The animation.
+        float rate;                        ///< The playback rate.
+        ServoAnimation::PlaybackMode mode; ///< What the animation does at the end.
+        unsigned int passes;               ///< The number of passes for a looping mode.
+    };
+
+    /**
+     * @brief Stop the currently playing servo animation. The mutex must already be held.
+     */
+    void _stop();
+
+    /**
+     * @brief Start playing an entry. The mutex must already be held.
+     * @param entry The animation to play.
+     * @param keep_mask Servos to keep in the channel mask, from the animation that played before.
+     */
+    void _start(const QueueEntry &entry, uint32_t keep_mask);
+
+    /**
+     * @brief Take the next entry from the queue and start it. The mutex must already be held.
+     * @return True if an animation was started, false if the queue is empty.
+     */
+    bool _startNext();
+
     ServoAnimation* _current_animation; ///< The currently playing servo animation.
-    bool _is_playing; ///< Flag indicating if a servo animation is currently playing.
+    std::atomic<bool> _is_playing; ///< Flag indicating if a servo animation is currently playing.
+    SemaphoreHandle_t _mutex; ///< Guards _current_animation between loop() and the motion task.
+    std::atomic<uint32_t> _carried_us; ///< Copied from the animation after each update for other tasks to read.
+    std::atomic<uint32_t> _max_lateness_us; ///< Copied from the animation after each update for other tasks to read.
+    std::atomic<uint32_t> _channel_mask; ///< The servos the current or last animation moves, worked out on play().
+    std::atomic<bool> _crossfade_pending; ///< play() cut into a running animation, see takeCrossfade().
+    bool _start_pending; ///< The animation hasn't been updated since play(). Guarded by the mutex.
+    unsigned long _play_requested_us; ///< micros() time of the last play() call. Guarded by the mutex.
+    std::atomic<uint32_t> _start_latency_us; ///< Time from the last play() to its first update.
+    std::atomic<uint32_t> _max_start_latency_us; ///< Longest start latency since boot.
+
+    // Queue, guarded by the mutex
+    QueueEntry _queue[QUEUE_CAPACITY]; ///< Ring of queued animations.
+    int _queue_head; ///< Index of the next animation in _queue.
+    int _queue_length; ///< Number of queued animations.
+    QueueEntry _current_entry; ///< How the current animation was started.
+    bool _current_queued; ///< The current animation came from the queue, so repeat puts it back.
+    bool _shuffle; ///< Pick the next animation at random.
+    bool _repeat; ///< Put finished animations back at the end of the queue.
+    uint32_t _shuffle_state; ///< State of the xorshift generator used to shuffle.
 };
 
 #endif // SERVO_PLAYER_H
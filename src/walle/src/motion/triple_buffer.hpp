@@ -0,0 +1,87 @@
+/**
+ * @file triple_buffer.hpp
+ * @author Isaac Rex (@Acliad)
+ * @brief This file contains the TripleBuffer class template, a lock-free way to hand the latest copy of a struct from
+ * one task to another.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+
+#include <atomic>
+#include <stdint.h>
+
+/**
+ * @brief A single producer, single consumer triple buffer.
+ *
+ * The writer fills write_buffer() and calls publish(). The reader calls update() and then uses read_buffer(). Neither
+ * side ever blocks or waits on the other: the writer always has a buffer of its own to fill, the reader always has a
+ * complete buffer to read, and the third buffer is swapped between them atomically. The reader only ever sees the most
+ * recently published value, older ones are dropped.
+ *
+ * NOTE: The buffer returned by write_buffer() still holds a value from an earlier publish, so every field must be
+ * written before publishing.
+ *
+ * @tparam T The type to pass between tasks. It is copied by value, so keep it small and trivially copyable.
+ */
+template <typename T> class TripleBuffer {
+  public:
+    /**
+     * @brief Constructs a TripleBuffer. All three buffers are value initialized.
+     */
+    TripleBuffer() : _buffers(), _write_idx(0), _middle(1), _read_idx(2) {
+    }
+
+    /**
+     * @brief Gets the buffer owned by the writer.
+     *
+     * @return The buffer to fill before calling publish().
+     */
+    T &write_buffer() {
+        return _buffers[_write_idx];
+    }
+
+    /**
+     * @brief Makes the write buffer available to the reader and takes the spare buffer to write into next.
+     */
+    void publish() {
+        _write_idx = _middle.exchange(_write_idx | _FRESH_BIT, std::memory_order_acq_rel) & _INDEX_MASK;
+    }
+
+    /**
+     * @brief Swaps in the most recently published buffer, if there is one the reader has not seen yet.
+     *
+     * @return True if read_buffer() now holds a new value, false if nothing was published since the last update().
+     */
+    bool update() {
+        if (!(_middle.load(std::memory_order_relaxed) & _FRESH_BIT)) {
+            return false;
+        }
+        _read_idx = _middle.exchange(_read_idx, std::memory_order_acq_rel) & _INDEX_MASK;
+        return true;
+    }
+
+    /**
+     * @brief Gets the buffer owned by the reader. It does not change until the next call to update().
+     *
+     * @return The latest value seen by update().
+     */
+    const T &read_buffer() const {
+        return _buffers[_read_idx];
+    }
+
+  private:
+    static const uint8_t _INDEX_MASK = 0x03;
+    static const uint8_t _FRESH_BIT = 0x04; // Set in _middle when it holds a value the reader has not taken yet
+
+    T                    _buffers[3]; /**< The three buffers. */
+    uint8_t              _write_idx;  /**< Index of the buffer owned by the writer. */
+    std::atomic<uint8_t> _middle;     /**< Index of the spare buffer, plus _FRESH_BIT. */
+    uint8_t              _read_idx;   /**< Index of the buffer owned by the reader. */
+};
+
+#endif // TRIPLE_BUFFER_HPP
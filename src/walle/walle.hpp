@@ -14,17 +14,30 @@
 
 #include "config.hpp"
 #include "src/controller/navigation_controller.hpp"
+#include "src/motion/pwm_frame.hpp"
+#include "src/motion/pwm_bus.hpp"
+#include "src/motion/pwm_board.hpp"
+#include "src/motion/pwm_address.hpp"
+#include "src/motion/pwm_board_group.hpp"
 #include "src/motion/drive_motor.hpp"
 #include "src/motion/servo_motor.hpp"
+#include "src/motion/servo_bank.hpp"
+#include "src/motion/servo_mixer.hpp"
+#include "src/motion/easing.hpp"
 #include "src/motion/animate_servo_recorder.hpp"
 #include "src/display/display.hpp"
 #include "src/button/button.hpp"
 #include "src/stats/stats.hpp"
 #include "src/motion/servo_player.hpp"
+#include "src/motion/motion_task.hpp"
+#include "src/motion/output_scheduler.hpp"
+#include "src/motion/triple_buffer.hpp"
 #include "display_animations.hpp"
 #include "motion_animations.hpp"
+#include "servo_joints.hpp"
 #include "src/motion/servo_context.hpp"
 #include "src/audio/audio_player.hpp"
+#include "src/audio/track_request.hpp"
 #include <Adafruit_PWMServoDriver.h>
 #include <Bluepad32.h>
 #include <Wire.h>
@@ -16,8 +16,19 @@
  **************************************************************/
 /*----------- PCA9685 PWM Module -------------------------*/
 const unsigned int PCA9685_OSCILLATION_FREQ = 25000000;
+const int          PCA9685_SDA_PIN = SDA;
+const int          PCA9685_SCL_PIN = SCL;
 const unsigned int SERVO_FREQ_HZ = 50; // NOTE: Analog servos run at ~50 Hz updates
 
+/*----------- Motion Task --------------------------------*/
+const unsigned long MOTION_TICK_US = 1000000UL / SERVO_FREQ_HZ / MOTION_TICKS_PER_PWM_PERIOD;
+#ifdef MOTION_ALIGN_OUTPUT_TO_PWM_PERIOD
+// With at least one control tick of lead, exactly one tick lands in the window before each period starts
+const unsigned long MOTION_OUTPUT_LEAD_US = MOTION_TICK_US + MOTION_OUTPUT_MARGIN_US;
+#else
+const unsigned long MOTION_OUTPUT_LEAD_US = 0;
+#endif
+
 /*----------- Controllers --------------------------------*/
 const unsigned int MAX_NUM_GAMEPADS = 2;
 
@@ -39,8 +50,10 @@ TFT_eSPI tft = TFT_eSPI();
 Display  display = Display(tft);
 
 /*----------- PCA9685 PWM Module -------------------------*/
-bool                    pca9685_connected = false;
-Adafruit_PWMServoDriver pca9685 = Adafruit_PWMServoDriver();
+PwmBus pwm_bus = PwmBus(Wire, PCA9685_SDA_PIN, PCA9685_SCL_PIN);
+// One board per address in PCA9685_I2C_ADDRESSES. Each collects its channels' output and flushes it once per period,
+// and re-attaches by itself after bus faults.
+PwmBoardGroup pwm_boards = PwmBoardGroup(pwm_bus, PCA9685_I2C_ADDRESSES, ARRAY_SIZE(PCA9685_I2C_ADDRESSES));
 
 /*----------- Track Motors -------------------------------*/
 float left_motor_speed = 0.0f;
@@ -48,41 +61,20 @@ float right_motor_speed = 0.0f;
 
 int track_velocity_profile_idx = TRACK_VELOCITY_DEFAULT_PROFILE_IDX;
 // NOTE: The motor constructor assumes the PCA9685 has already been initialized
-DriveMotor motor_r = DriveMotor(&pca9685, MOTOR_RIGHT_IDX);
-DriveMotor motor_l = DriveMotor(&pca9685, MOTOR_LEFT_IDX);
-
-/*----------- Head Servos --------------------------------*/
-float neck_yaw_position = 0.0f;
-float neck_pitch_position = 0.0f;
-float eye_left_position = 0.0f;
-float eye_right_position = 0.0f;
-
-// NOTE: Initializing with default parameters here, updated in initServos()
-ServoMotor servo_neck_yaw(&pca9685, SERVO_NECK_YAW_IDX, SERVO_NECK_YAW_NAME);
-ServoMotor servo_neck_pitch(&pca9685, SERVO_NECK_PITCH_IDX, SERVO_NECK_PITCH_NAME);
-ServoMotor servo_eye_left(&pca9685, SERVO_EYE_LEFT_IDX, SERVO_EYE_LEFT_NAME);
-ServoMotor servo_eye_right(&pca9685, SERVO_EYE_RIGHT_IDX, SERVO_EYE_RIGHT_NAME);
-
-/*----------- Arm Servos ---------------------------------*/
-float shoulder_left_position = 0.0f;
-float shoulder_right_position = 0.0f;
-float elbow_left_position = 0.0f;
-float elbow_right_position = 0.0f;
-float wrist_left_position = 0.0f;
-float wrist_right_position = 0.0f;
-float hand_left_position = 0.0f;
-float hand_right_position = 0.0f;
-
-ServoMotor servo_shoulder_left(&pca9685, SERVO_SHOULDER_LEFT_IDX, SERVO_SHOULDER_LEFT_NAME);
-ServoMotor servo_shoulder_right(&pca9685, SERVO_SHOULDER_RIGHT_IDX, SERVO_SHOULDER_RIGHT_NAME);
-ServoMotor servo_elbow_left(&pca9685, SERVO_ELBOW_LEFT_IDX, SERVO_ELBOW_LEFT_NAME);
-ServoMotor servo_elbow_right(&pca9685, SERVO_ELBOW_RIGHT_IDX, SERVO_ELBOW_RIGHT_NAME);
-ServoMotor servo_wrist_left(&pca9685, SERVO_WRIST_LEFT_IDX, SERVO_WRIST_LEFT_NAME);
-ServoMotor servo_wrist_right(&pca9685, SERVO_WRIST_RIGHT_IDX, SERVO_WRIST_RIGHT_NAME);
-ServoMotor servo_hand_left(&pca9685, SERVO_HAND_LEFT_IDX, SERVO_HAND_LEFT_NAME);
-ServoMotor servo_hand_right(&pca9685, SERVO_HAND_RIGHT_IDX, SERVO_HAND_RIGHT_NAME);
+DriveMotor motor_r = DriveMotor(&pwm_boards, MOTOR_RIGHT_ADDR);
+DriveMotor motor_l = DriveMotor(&pwm_boards, MOTOR_LEFT_ADDR);
+
+/*----------- Servos -------------------------------------*/
+// Position of each servo as a scalar from -1.0 to 1.0, indexed by ServoId
+float servo_positions[SERVO_ID_COUNT] = {};
+// Servos the operator has moved during the current animation, they stay under manual control until it ends
+ServoMixer::ChannelMask manual_override_mask = 0;
 
+// The servos and their limits are described by SERVO_JOINTS, built from config.hpp at compile time
+ServoBank    servo_bank = ServoBank(&pwm_boards, SERVO_JOINTS, NUM_SERVO_JOINTS);
 ServoContext servo_context;
+// Lays animations over the operator's pose and lets manual control take joints back, see updateMotion()
+ServoMixer servo_mixer = ServoMixer(&servo_bank);
 
 /*----------- Audio Player -------------------------------*/
 unsigned int audio_current_track = 0;
@@ -134,6 +126,32 @@ ServoAnimation         *head_animations[] = {
 };
 ServoPlayer &servo_player = ServoPlayer::getInstance();
 
+/*----------- Motion Task --------------------------------*/
+// Targets from loop() for the motion task. Every field is written before each publish.
+struct MotionTargets {
+    float    left_motor_speed;
+    float    right_motor_speed;
+    int      track_velocity_profile_idx;
+    float    servo_positions[SERVO_ID_COUNT];
+    uint32_t manual_mask;       // Servos manual control overrides an animation on
+    uint32_t feedback_seq_seen; // Sequence number of the newest MotionFeedback loop() has read
+};
+
+// Servo positions from the motion task back to loop(), so manual control picks up where an animation left off
+struct MotionFeedback {
+    uint32_t seq;             // Incremented every tick
+    bool     servos_animated; // True while an animation drives some of the servos
+    uint32_t animated_mask;   // The servos the animation drives rather than the targets
+    float    servo_positions[SERVO_ID_COUNT];
+};
+
+TripleBuffer<MotionTargets>  motion_targets;
+TripleBuffer<MotionFeedback> motion_feedback;
+uint32_t                     motion_feedback_seq_seen = 0;
+// Runs MOTION_TICKS_PER_PWM_PERIOD times per servo PWM period, each board picks the tick that writes its outputs
+void       updateMotion();
+MotionTask motion_task = MotionTask(updateMotion, MOTION_TICK_US);
+
 /**************************************************************
  *                    Function Prototypes                     *
  **************************************************************/
@@ -145,6 +163,12 @@ void mapInputs(float dt);
 /*----------- Audio Player -------------------------------*/
 void playRandomTrack();
 
+/*----------- Servos -------------------------------------*/
+void moveServoPosition(int id, float input, float dt);
+
+/*----------- Motion Task --------------------------------*/
+void exchangeMotionState();
+
 /*----------- General ------------------------------------*/
 void updateAll();
 
@@ -171,26 +195,30 @@ void setup() {
 
     /*----------- PCA9685 PWM Module ----------------------*/
     Serial.println("Initializing PCA9685");
-    pca9685_connected = pca9685.begin();
-    if (!pca9685_connected) {
-        Serial.println("************> Initialization failed...");
-    } else {
-        pca9685.setOscillatorFrequency(PCA9685_OSCILLATION_FREQ);
-        pca9685.setPWMFreq(SERVO_FREQ_HZ);
+    pwm_bus.begin();
+    // Also calculates the us to tick conversion once so channel writes never need the prescaler or floating point
+    int boards_attached = pwm_boards.begin(PCA9685_OSCILLATION_FREQ, SERVO_FREQ_HZ, MOTION_OUTPUT_LEAD_US);
+    if (boards_attached < pwm_boards.get_num_boards()) {
+        Serial.printf("************> Initialization failed for %d of %d boards, retrying in the background...\n",
+                      pwm_boards.get_num_boards() - boards_attached, pwm_boards.get_num_boards());
     }
 
-    /*----------- Drive Motors ---------------------------*/
-    // Set the default max speed
-    motor_r.set_speed_limit(TRACK_VELOCITY_PROFILES[track_velocity_profile_idx].speed_scaler);
-    motor_l.set_speed_limit(TRACK_VELOCITY_PROFILES[track_velocity_profile_idx].speed_scaler);
-
-    // Set the default acceleration
-    motor_r.set_acceleration(TRACK_VELOCITY_PROFILES[track_velocity_profile_idx].acceleration);
-    motor_l.set_acceleration(TRACK_VELOCITY_PROFILES[track_velocity_profile_idx].acceleration);
-
     /*----------- Servo Motors ---------------------------*/
+#ifdef EASING_BENCHMARK_ON_STARTUP
+    ease_benchmark();
+#endif
     initServos();
-    MotionAnimations::setup_animations(servo_context);
+    servo_mixer.set_layer(ServoMixer::BASE, ServoMixer::ALL_CHANNELS, 1.0f); // The operator's pose
+    MotionAnimations::setup_animations(servo_context, 1000000UL / SERVO_FREQ_HZ); // Bake one frame per PWM period
+
+    /*----------- Motion Task ----------------------------*/
+    // NOTE: The motion task owns the motors, servos, servo_player updates and pwm_boards from here on. The track
+    // velocity profile is applied by the task on its first tick. The task runs even if a PCA9685 isn't attached yet,
+    // pwm_boards attaches it whenever it shows up.
+    exchangeMotionState(); // Publish the starting targets before the first tick
+    if (!motion_task.begin(MOTION_TASK_CORE, MOTION_TASK_PRIORITY, MOTION_TASK_STACK_BYTES)) {
+        Serial.println("************> Motion task creation failed...");
+    }
 
     /*----------- Controllers ----------------------------*/
     Serial.println("Initializing Controller...");
@@ -261,10 +289,41 @@ void loop() {
         Serial.println("Right Motor Speed: " + String(right_motor_speed));
         Serial.print("Speed Scaler: ");
         Serial.println(motor_l.get_speed_limit());
+        Serial.printf("Servo PWM writes (issued/skipped): %lu/%lu\n", servo_bank.get_writes_issued(),
+                      servo_bank.get_writes_skipped());
+        Serial.printf("Track PWM writes (issued/skipped): %lu/%lu\n",
+                      motor_l.get_writes_issued() + motor_r.get_writes_issued(),
+                      motor_l.get_writes_skipped() + motor_r.get_writes_skipped());
+        for (int i = 0; i < pwm_boards.get_num_boards(); i++) {
+            PwmBoard *board = pwm_boards.get_board(i);
+            PwmFrame &frame = board->get_frame();
+            Serial.printf("PCA9685 %d transactions/channel writes: %lu/%lu\n", i, frame.get_transactions(),
+                          frame.get_channel_writes());
+            Serial.printf("PCA9685 %d %s | I2C errors: %lu (last %u) | latency avg/max (us): %lu/%lu\n", i,
+                          board->is_attached() ? "attached" : "DETACHED", frame.get_errors(), frame.get_last_error(),
+                          (unsigned long)frame.get_latency_average_us(), (unsigned long)frame.get_latency_max_us());
+            Serial.printf("PCA9685 %d faults: %lu | last downtime (us): %lu | period outputs (total/late): %lu/%lu\n",
+                          i, board->get_faults(), board->get_last_downtime_us(), board->get_scheduler().get_outputs(),
+                          board->get_scheduler().get_late_outputs());
+        }
+        Serial.printf("PCA9685 bus clears: %lu\n", pwm_bus.get_clears());
+        Serial.printf("Animation timing error carried/max (us): %lu/%lu\n", (unsigned long)servo_player.getCarriedUs(),
+                      (unsigned long)servo_player.getMaxLatenessUs());
+        Serial.printf("Animation start latency last/max (us): %lu/%lu\n",
+                      (unsigned long)servo_player.getStartLatencyUs(),
+                      (unsigned long)servo_player.getMaxStartLatencyUs());
+        Serial.printf("Motion task jitter avg/max (us): %lu/%lu | tick max (us): %lu | overruns: %lu\n",
+                      (unsigned long)motion_task.get_jitter_average_us(),
+                      (unsigned long)motion_task.get_jitter_max_us(),
+                      (unsigned long)motion_task.get_tick_max_us(), (unsigned long)motion_task.get_overruns());
         // Serial.print("Loop time (ms): ");
         // Serial.println(loop_stats.average());
-        // Serial.print("Free heap bytes: ");
-        // Serial.println(ESP.getFreeHeap());
+        // Fragmentation is the share of the free heap that can't be had in one block
+        uint32_t free_heap = ESP.getFreeHeap();
+        uint32_t largest_block = ESP.getMaxAllocHeap();
+        Serial.printf("Heap free/largest block (bytes): %u/%u | peak used: %u | fragmentation: %u%%\n", free_heap,
+                      largest_block, ESP.getHeapSize() - ESP.getMinFreeHeap(),
+                      free_heap == 0 ? 0 : 100 - (unsigned int)((uint64_t)largest_block * 100 / free_heap));
         Serial.println("--------------------------------------------------");
     }
 }
@@ -272,124 +331,17 @@ void loop() {
 /**
  * @brief Initializes the servos.
  * 
- * This function adds the servos to the global servo context and sets up their ramp mode and parameters.
- * It also sets the min, max, and neutral values for each servo.
- * Finally, it sets all the motors to their neutral position.
+ * This function adds the servos to the global servo context. Their limits and ramp modes come from SERVO_JOINTS, and
+ * the servo bank starts every servo at its neutral position.
  */
 void initServos() {
-    /*************************************
-     * Add servos to global servo context
-     *************************************/
-    servo_context.map[SERVO_NECK_YAW_NAME] = &servo_neck_yaw;
-    servo_context.map[SERVO_NECK_PITCH_NAME] = &servo_neck_pitch;
-
-    servo_context.map[SERVO_EYE_LEFT_NAME] = &servo_eye_left;
-    servo_context.map[SERVO_EYE_RIGHT_NAME] = &servo_eye_right;
-
-    servo_context.map[SERVO_SHOULDER_LEFT_NAME] = &servo_shoulder_left;
-    servo_context.map[SERVO_SHOULDER_RIGHT_NAME] = &servo_shoulder_right;
-
-    servo_context.map[SERVO_ELBOW_LEFT_NAME] = &servo_elbow_left;
-    servo_context.map[SERVO_ELBOW_RIGHT_NAME] = &servo_elbow_right;
-
-    servo_context.map[SERVO_WRIST_LEFT_NAME] = &servo_wrist_left;
-    servo_context.map[SERVO_WRIST_RIGHT_NAME] = &servo_wrist_right;
-
-    servo_context.map[SERVO_HAND_LEFT_NAME] = &servo_hand_left;
-    servo_context.map[SERVO_HAND_RIGHT_NAME] = &servo_hand_right;
-
-    /*************************************
-     * Setup the ramp modes
-     *************************************/
-    servo_neck_yaw.set_ramp_mode(SINUSOIDAL_INOUT);
-    servo_neck_pitch.set_ramp_mode(SINUSOIDAL_INOUT);
-
-    servo_eye_left.set_ramp_mode(SINUSOIDAL_INOUT);
-    servo_eye_right.set_ramp_mode(SINUSOIDAL_INOUT);
-
-    servo_shoulder_left.set_ramp_mode(SINUSOIDAL_INOUT);
-    servo_shoulder_right.set_ramp_mode(SINUSOIDAL_INOUT);
-
-    servo_elbow_left.set_ramp_mode(SINUSOIDAL_INOUT);
-    servo_elbow_right.set_ramp_mode(SINUSOIDAL_INOUT);
-    
-    servo_wrist_left.set_ramp_mode(SINUSOIDAL_INOUT);
-    servo_wrist_right.set_ramp_mode(SINUSOIDAL_INOUT);
-    
-    servo_hand_left.set_ramp_mode(SINUSOIDAL_INOUT);
-    servo_hand_right.set_ramp_mode(SINUSOIDAL_INOUT);
-
-    /*************************************
-     * Setup the min, max, and neutral values
-     *************************************/
-    servo_eye_right.set_max_us(SERVO_EYE_RIGHT_MAX_US);
-    servo_eye_right.set_min_us(SERVO_EYE_RIGHT_MIN_US);
-    servo_eye_right.set_neutral_us(SERVO_EYE_RIGHT_NEUTRAL_US);
-
-    servo_eye_left.set_max_us(SERVO_EYE_LEFT_MAX_US);
-    servo_eye_left.set_min_us(SERVO_EYE_LEFT_MIN_US);
-    servo_eye_left.set_neutral_us(SERVO_EYE_LEFT_NEUTRAL_US);
-
-    servo_neck_pitch.set_max_us(SERVO_NECK_PITCH_MAX_US);
-    servo_neck_pitch.set_min_us(SERVO_NECK_PITCH_MIN_US);
-    servo_neck_pitch.set_neutral_us(SERVO_NECK_PITCH_NEUTRAL_US);
-
-    servo_neck_yaw.set_max_us(SERVO_NECK_YAW_MAX_US);
-    servo_neck_yaw.set_min_us(SERVO_NECK_YAW_MIN_US);
-    servo_neck_yaw.set_neutral_us(SERVO_NECK_YAW_NEUTRAL_US);
-
-    servo_shoulder_left.set_max_us(SERVO_SHOULDER_MAX_US);
-    servo_shoulder_left.set_min_us(SERVO_SHOULDER_MIN_US);
-    servo_shoulder_left.set_neutral_us(SERVO_SHOULDER_NEUTRAL_US);
-
-    servo_shoulder_right.set_max_us(SERVO_SHOULDER_MAX_US);
-    servo_shoulder_right.set_min_us(SERVO_SHOULDER_MIN_US);
-    servo_shoulder_right.set_neutral_us(SERVO_SHOULDER_NEUTRAL_US);
-
-    servo_elbow_left.set_max_us(SERVO_ELBOW_MAX_US);
-    servo_elbow_left.set_min_us(SERVO_ELBOW_MIN_US);
-    servo_elbow_left.set_neutral_us(SERVO_ELBOW_NEUTRAL_US);
-
-    servo_elbow_right.set_max_us(SERVO_ELBOW_MAX_US);
-    servo_elbow_right.set_min_us(SERVO_ELBOW_MIN_US);
-    servo_elbow_right.set_neutral_us(SERVO_ELBOW_NEUTRAL_US);
-
-    servo_wrist_left.set_max_us(SERVO_WRIST_MAX_US);
-    servo_wrist_left.set_min_us(SERVO_WRIST_MIN_US);
-    servo_wrist_left.set_neutral_us(SERVO_WRIST_NEUTRAL_US);
-
-    servo_wrist_right.set_max_us(SERVO_WRIST_MAX_US);
-    servo_wrist_right.set_min_us(SERVO_WRIST_MIN_US);
-    servo_wrist_right.set_neutral_us(SERVO_WRIST_NEUTRAL_US);
-
-    servo_hand_left.set_max_us(SERVO_HAND_MAX_US);
-    servo_hand_left.set_min_us(SERVO_HAND_MIN_US);
-    servo_hand_left.set_neutral_us(SERVO_HAND_NEUTRAL_US);
-
-    servo_hand_right.set_max_us(SERVO_HAND_MAX_US);
-    servo_hand_right.set_min_us(SERVO_HAND_MIN_US);
-    servo_hand_right.set_neutral_us(SERVO_HAND_NEUTRAL_US);
-
-    /*************************************
-     * Inialize all the servo positions
-     *************************************/
-    servo_neck_yaw.set_angle(0.0f, 0);
-    servo_neck_pitch.set_angle(0.0f, 0);
-
-    servo_eye_left.set_scalar(0.0f, 0);
-    servo_eye_right.set_scalar(0.0f, 0);
-
-    servo_shoulder_left.set_scalar(0.0f, 0);
-    servo_shoulder_right.set_scalar(0.0f, 0);
-
-    servo_elbow_left.set_scalar(0.0f, 0);
-    servo_elbow_right.set_scalar(0.0f, 0);
-
-    servo_wrist_left.set_scalar(0.0f, 0);
-    servo_wrist_right.set_scalar(0.0f, 0);
-
-    servo_hand_left.set_scalar(0.0f, 0);
-    servo_hand_right.set_scalar(0.0f, 0);
+    for (int id = 0; id < servo_bank.get_num_servos(); id++) {
+        ServoMotor *servo = servo_bank.get_servo(id);
+        if (!servo_context.add(servo)) {
+            Serial.printf("************> %s shares an ID, name or board and channel with another servo...\n",
+                          servo->get_name());
+        }
+    }
 }
 
 /**
@@ -494,10 +446,9 @@ void onConnectedGamepad(GamepadPtr gp) {
 void onDisconnectedGamepad(GamepadPtr gp) {
     // If the controller is the main controller, stop WALL-E
     if (gp == drive_controller.getGamepad()) {
-        if (pca9685_connected) {
-            motor_r.set_speed(0);
-            motor_l.set_speed(0);
-        }
+        // The motion task picks these up with the next targets
+        left_motor_speed = 0.0f;
+        right_motor_speed = 0.0f;
     }
 
     // Find the gamepad in the list of controllers and update the entry
@@ -534,81 +485,127 @@ bool isGamepadConnected() {
 }
 
 /**
- * @brief Updates all components of the Wall-E robot with update functions.
+ * @brief Runs one tick of the motion task.
  *
- * This function updates the display, motors/servos, and controllers of the Wall-E robot.
- * It is called periodically to ensure that all components are functioning properly.
+ * Called MOTION_TICKS_PER_PWM_PERIOD times per servo PWM period from the motion task. Updates the drive motor ramps,
+ * runs the current animation and mixes it with the targets from loop(). Once per PWM period, when its output
+ * scheduler says so, every changed channel of a PCA9685 is flushed to it in one burst.
+ *
+ * The servos are mixed in layers by servo_mixer: the targets from loop() as the base, the animation over the servos it
+ * moves, and manual control over the servos the operator has taken back from the animation. So an animation only
+ * takes the joints it moves and the operator keeps driving the rest. An animation that cuts into another one is
+ * crossfaded in over ANIMATION_CROSSFADE_MS.
+ *
+ * Once an animation ends its servos hold its final pose until loop() has read it back into servo_positions.
+ * Otherwise the first targets after the animation would still hold the pose from before it, and the servos would jump.
  */
-void updateAll() {
-    /*----------- Display --------------------------------*/
-    display.update();
+void updateMotion() {
+    static int      applied_velocity_profile_idx = -1;
+    static uint32_t feedback_seq = 0;
+    static uint32_t animated_seq = 0; // Sequence number of the last tick driven by an animation
 
-    /*----------- Motors/Servors -------------------------*/
-    if (pca9685_connected) {
-        // Update motors
-        motor_r.set_speed(right_motor_speed);
-        motor_l.set_speed(left_motor_speed);
-        motor_r.update();
-        motor_l.update();
+    motion_targets.update();
+    const MotionTargets &targets = motion_targets.read_buffer();
+
+    /*----------- Drive Motors ---------------------------*/
+    if (targets.track_velocity_profile_idx != applied_velocity_profile_idx) {
+        applied_velocity_profile_idx = targets.track_velocity_profile_idx;
+        float motor_speed_factor = TRACK_VELOCITY_PROFILES[applied_velocity_profile_idx].speed_scaler;
+        float motor_acceleration = TRACK_VELOCITY_PROFILES[applied_velocity_profile_idx].acceleration;
+
+        motor_r.set_speed_limit(motor_speed_factor);
+        motor_l.set_speed_limit(motor_speed_factor);
+        motor_r.set_acceleration(motor_acceleration);
+        motor_l.set_acceleration(motor_acceleration);
+    }
+    motor_r.set_speed(targets.right_motor_speed);
+    motor_l.set_speed(targets.left_motor_speed);
+    motor_r.update();
+    motor_l.update();
+
+    /*----------- Servos ---------------------------------*/
+    MotionFeedback &feedback = motion_feedback.write_buffer();
+    feedback.seq = ++feedback_seq;
+    // One timestamp for the whole servo update, so the animation timeline and the ramps agree on the time
+    unsigned long now_us = micros();
+    if (servo_player.isPlaying()) {
+        servo_player.update(now_us);
+        animated_seq = feedback.seq;
+    }
+    feedback.servos_animated = targets.feedback_seq_seen < animated_seq;
+
+    ServoMixer::ChannelMask animation_mask = feedback.servos_animated ? servo_player.getChannelMask() : 0;
+    servo_mixer.set_layer(ServoMixer::ANIMATION, animation_mask, 1.0f);
+    servo_mixer.set_layer(ServoMixer::MANUAL, targets.manual_mask, 1.0f);
+    servo_mixer.set_pose(ServoMixer::BASE, targets.servo_positions);
+    servo_mixer.set_pose(ServoMixer::MANUAL, targets.servo_positions);
+    if (servo_player.takeCrossfade()) {
+        servo_mixer.start_crossfade(now_us, ANIMATION_CROSSFADE_MS * 1000UL);
+    }
+    servo_mixer.update(now_us);
+    feedback.animated_mask = animation_mask & ~targets.manual_mask;
 
-        // Update servos unless animating
-        if (servo_player.isPlaying()) {
-            servo_player.update();
+    servo_bank.get_scalars(feedback.servo_positions);
+    motion_feedback.publish();
 
-            // Update the tracked positions
-            neck_yaw_position = servo_neck_yaw.get_scalar();
-            neck_pitch_position = servo_neck_pitch.get_scalar();
+    // Each board sends its newest values once per PWM period, on its own schedule. This is also where a faulted
+    // PCA9685 gets re-attached.
+    pwm_boards.update(micros());
+}
 
-            eye_left_position = servo_eye_left.get_scalar();
-            eye_right_position = servo_eye_right.get_scalar();
+/**
+ * @brief Swaps state with the motion task.
+ *
+ * Reads back the positions of the servos an animation drives, then publishes the latest targets from loop(). Neither
+ * side blocks.
+ */
+void exchangeMotionState() {
+    if (motion_feedback.update()) {
+        const MotionFeedback &feedback = motion_feedback.read_buffer();
+        // Update the tracked positions of the animated servos
+        for (int id = 0; id < SERVO_ID_COUNT; id++) {
+            if (feedback.animated_mask & ServoMixer::channel(id)) {
+                servo_positions[id] = feedback.servo_positions[id];
+            }
+        }
+        if (!feedback.servos_animated) {
+            manual_override_mask = 0; // The next animation gets every joint it moves
+        }
+        motion_feedback_seq_seen = feedback.seq;
+    }
 
-            shoulder_left_position = servo_shoulder_left.get_scalar();
-            shoulder_right_position = servo_shoulder_right.get_scalar();
+    MotionTargets &targets = motion_targets.write_buffer();
+    targets.left_motor_speed = left_motor_speed;
+    targets.right_motor_speed = right_motor_speed;
+    targets.track_velocity_profile_idx = track_velocity_profile_idx;
 
-            elbow_left_position = servo_elbow_left.get_scalar();
-            elbow_right_position = servo_elbow_right.get_scalar();
+    for (int id = 0; id < SERVO_ID_COUNT; id++) {
+        targets.servo_positions[id] = servo_positions[id];
+    }
+    targets.manual_mask = manual_override_mask;
 
-            wrist_left_position = servo_wrist_left.get_scalar();
-            wrist_right_position = servo_wrist_right.get_scalar();
+    targets.feedback_seq_seen = motion_feedback_seq_seen;
+    motion_targets.publish();
+}
 
-            hand_left_position = servo_hand_left.get_scalar();
-            hand_right_position = servo_hand_right.get_scalar();
-        } else {
-            // Set servo positions
-            servo_neck_yaw.set_scalar(neck_yaw_position, 0);
-            servo_neck_pitch.set_scalar(neck_pitch_position, 0);
-
-            servo_eye_left.set_scalar(eye_left_position, 0);
-            servo_eye_right.set_scalar(eye_right_position, 0);
-
-            servo_shoulder_left.set_scalar(shoulder_left_position, 0);
-            servo_shoulder_right.set_scalar(shoulder_right_position, 0);
-
-            servo_elbow_left.set_scalar(elbow_left_position, 0);
-            servo_elbow_right.set_scalar(elbow_right_position, 0);
-
-            servo_wrist_left.set_scalar(wrist_left_position, 0);
-            servo_wrist_right.set_scalar(wrist_right_position, 0);
-
-            servo_hand_left.set_scalar(hand_left_position, 0);
-            servo_hand_right.set_scalar(hand_right_position, 0);
-
-            servo_neck_yaw.update();
-            servo_neck_pitch.update();
-            servo_eye_left.update();
-            servo_eye_right.update();
-            servo_shoulder_left.update();
-            servo_shoulder_right.update();
-            servo_elbow_left.update();
-            servo_elbow_right.update();
-            servo_wrist_left.update();
-            servo_wrist_right.update();
-            servo_hand_left.update();
-            servo_hand_right.update();
-        }
+/**
+ * @brief Updates all components of the Wall-E robot with update functions.
+ *
+ * This function updates the display, hands targets to the motion task, and updates the controllers of the Wall-E
+ * robot. It is called periodically to ensure that all components are functioning properly. The motors and servos
+ * themselves are updated by the motion task.
+ */
+void updateAll() {
+    /*----------- Display --------------------------------*/
+    display.update();
+
+    /*----------- Motors/Servors -------------------------*/
+    if (motion_task.isRunning()) {
+        exchangeMotionState();
     }
 
     /*----------- Audio Player ---------------------------*/
+    TrackRequest::service(); // Tracks requested by animation keyframes on the motion task
     dfmp3.loop();
 
     /*----------- Controllers ----------------------------*/
@@ -632,6 +629,21 @@ void playRandomTrack() {
     dfmp3.playMp3FolderTrack(track_index);
 }
 
+/**
+ * @brief Moves a servo's position at its joint's rate, keeping it within -1.0 to 1.0. Moving a servo takes it over
+ * from a running animation until the animation ends.
+ *
+ * @param id The ServoId of the servo.
+ * @param input The control input from -1.0 to 1.0, scales the joint's rate_per_s.
+ * @param dt The time interval since the last update.
+ */
+void moveServoPosition(int id, float input, float dt) {
+    servo_positions[id] = constrain(servo_positions[id] + SERVO_JOINTS[id].rate_per_s * input * dt, -1.0f, 1.0f);
+    if (input != 0.0f) {
+        manual_override_mask |= ServoMixer::channel(id);
+    }
+}
+
 /**
  * Maps the inputs from various controllers to control the movement, position, animations, and sounds of Wall-E.
  * 
@@ -653,13 +665,7 @@ void mapInputs(float dt) {
             // Increase the speed profile to the next in the array
             // *****************************
             track_velocity_profile_idx = max((track_velocity_profile_idx - 1), 0);
-            float motor_speed_factor = TRACK_VELOCITY_PROFILES[track_velocity_profile_idx].speed_scaler;
-            float motor_acceleration = TRACK_VELOCITY_PROFILES[track_velocity_profile_idx].acceleration;
-
-            motor_r.set_speed_limit(motor_speed_factor);
-            motor_l.set_speed_limit(motor_speed_factor);
-            motor_r.set_acceleration(motor_acceleration);
-            motor_l.set_acceleration(motor_acceleration);
+            // NOTE: Applied to the motors by the motion task
         }
 
         if (drive_controller.circleWasPressed()) {
@@ -667,69 +673,54 @@ void mapInputs(float dt) {
             // Decrease the speed profile to the next in the array
             // *****************************
             track_velocity_profile_idx = min((track_velocity_profile_idx + 1), ARRAY_SIZE(TRACK_VELOCITY_PROFILES)-1);
-            float motor_speed_factor = TRACK_VELOCITY_PROFILES[track_velocity_profile_idx].speed_scaler;
-            float motor_acceleration = TRACK_VELOCITY_PROFILES[track_velocity_profile_idx].acceleration;
-
-            motor_r.set_speed_limit(motor_speed_factor);
-            motor_l.set_speed_limit(motor_speed_factor);
-            motor_r.set_acceleration(motor_acceleration);
-            motor_l.set_acceleration(motor_acceleration);
+            // NOTE: Applied to the motors by the motion task
         }
     }
     /*----------- Head Movement --------------------------*/
     if (!modifier_pressed) {
         // If not relavent modifier is pressed...
-        neck_pitch_position =
-            constrain(neck_pitch_position + HEAD_PITCH_RATE_PER_S * -aux_controller.thumbstickYNorm() * dt, -1.0f, 1.0f);
-        neck_yaw_position =
-            constrain(neck_yaw_position + HEAD_YAW_RATE_PER_S * aux_controller.thumbstickXNorm() * dt, -1.0f, 1.0f);
+        moveServoPosition(SERVO_ID_NECK_PITCH, -aux_controller.thumbstickYNorm(), dt);
+        moveServoPosition(SERVO_ID_NECK_YAW, aux_controller.thumbstickXNorm(), dt);
     }
 
     if (aux_controller.l2IsPressed()) {
-        eye_left_position =
-            constrain(eye_left_position + EYE_MOVE_RATE_PER_S * -drive_controller.thumbstickYNorm() * dt, -1.0f, 1.0f);
-        eye_right_position =
-            constrain(eye_right_position + EYE_MOVE_RATE_PER_S * aux_controller.thumbstickYNorm() * dt, -1.0f, 1.0f);
+        moveServoPosition(SERVO_ID_EYE_LEFT, -drive_controller.thumbstickYNorm(), dt);
+        moveServoPosition(SERVO_ID_EYE_RIGHT, aux_controller.thumbstickYNorm(), dt);
     }
     /*----------- Arm Movement ---------------------------*/
     if (drive_controller.l2IsPressed()) {
         // ----------- Shoulders -----------
-        shoulder_left_position = constrain(
-            shoulder_left_position + SHOULDER_MOVE_RATE_PER_S * -drive_controller.thumbstickYNorm() * dt, -1.0f, 1.0f);
-        shoulder_right_position = constrain(
-            shoulder_right_position + SHOULDER_MOVE_RATE_PER_S * -aux_controller.thumbstickYNorm() * dt, -1.0f, 1.0f);
+        moveServoPosition(SERVO_ID_SHOULDER_LEFT, -drive_controller.thumbstickYNorm(), dt);
+        moveServoPosition(SERVO_ID_SHOULDER_RIGHT, -aux_controller.thumbstickYNorm(), dt);
 
         // ------------ Elbows -------------
-        elbow_left_position = constrain(
-            elbow_left_position + ELBOW_MOVE_RATE_PER_S * drive_controller.thumbstickXNorm() * dt, -1.0f, 1.0f);
-        elbow_right_position = constrain(
-            elbow_right_position + ELBOW_MOVE_RATE_PER_S * aux_controller.thumbstickXNorm() * dt, -1.0f, 1.0f);
+        moveServoPosition(SERVO_ID_ELBOW_LEFT, drive_controller.thumbstickXNorm(), dt);
+        moveServoPosition(SERVO_ID_ELBOW_RIGHT, aux_controller.thumbstickXNorm(), dt);
 
     } else if (drive_controller.l1IsPressed()) {
         // ------------- Wrists ------------
-        wrist_left_position = constrain(
-            wrist_left_position + WRIST_MOVE_RATE_PER_S * drive_controller.thumbstickXNorm() * dt, -1.0f, 1.0f);
-        wrist_right_position = constrain(
-            wrist_right_position + WRIST_MOVE_RATE_PER_S * aux_controller.thumbstickXNorm() * dt, -1.0f, 1.0f);
+        moveServoPosition(SERVO_ID_WRIST_LEFT, drive_controller.thumbstickXNorm(), dt);
+        moveServoPosition(SERVO_ID_WRIST_RIGHT, aux_controller.thumbstickXNorm(), dt);
 
         // ------------- Hands -------------
-        hand_left_position = constrain(
-            hand_left_position + HAND_MOVE_RATE_PER_S * -drive_controller.thumbstickYNorm() * dt, -1.0f, 1.0f);
-        hand_right_position =
-            constrain(hand_right_position + HAND_MOVE_RATE_PER_S * -aux_controller.thumbstickYNorm() * dt, -1.0f, 1.0f);
+        moveServoPosition(SERVO_ID_HAND_LEFT, -drive_controller.thumbstickYNorm(), dt);
+        moveServoPosition(SERVO_ID_HAND_RIGHT, -aux_controller.thumbstickYNorm(), dt);
     }
 
     /*----------- Animations -----------------------------*/
     int animation_index_offset = drive_controller.l2IsPressed() ? ANIMATION_MODIFIER_OFFSET : 0;
+    // Holding L1 keeps the animation going back and forth until it is stopped, for idle motions
+    ServoAnimation::PlaybackMode animation_mode =
+        drive_controller.l1IsPressed() ? ServoAnimation::PING_PONG : ServoAnimation::ONCE;
     if (state == WallEState::NORMAL) {
         if (drive_controller.upWasPressed()) {
-            servo_player.play(head_animations[DPAD_UP_INDEX + animation_index_offset]);
+            servo_player.play(head_animations[DPAD_UP_INDEX + animation_index_offset], 1.0f, animation_mode);
         } else if (drive_controller.rightWasPressed()) {
-            servo_player.play(head_animations[DPAD_RIGHT_INDEX + animation_index_offset]);
+            servo_player.play(head_animations[DPAD_RIGHT_INDEX + animation_index_offset], 1.0f, animation_mode);
         } else if (drive_controller.downWasPressed()) {
-            servo_player.play(head_animations[DPAD_DOWN_INDEX + animation_index_offset]);
+            servo_player.play(head_animations[DPAD_DOWN_INDEX + animation_index_offset], 1.0f, animation_mode);
         } else if (drive_controller.leftWasPressed()) {
-            servo_player.play(head_animations[DPAD_LEFT_INDEX + animation_index_offset]);
+            servo_player.play(head_animations[DPAD_LEFT_INDEX + animation_index_offset], 1.0f, animation_mode);
         }
         if (drive_controller.thumbstickWasPressed()) {
             servo_player.stop();
@@ -760,10 +751,13 @@ void mapInputs(float dt) {
     }
 
     /*----------- Buttons --------------------------------*/
+    // The recorder drives the servos itself, so stop any animation (a looping one never ends on its own) first
     if (state == WallEState::NORMAL && button_record.wasPressed()) {
+        servo_player.stop();
         state = WallEState::RECORDING_NEW;
         servo_recorder = new ServoAnimationRecorder(display, servo_context);
     } else if (state == WallEState::NORMAL && button_play.wasPressed()) {
+        servo_player.stop();
         state = WallEState::RECORDING_EDIT;
         servo_recorder = new ServoAnimationRecorder(display, servo_context);
     }
@@ -816,6 +810,8 @@ void mapInputs(float dt) {
             recorder_state = servo_recorder->inputEvent(ServoAnimationRecorder::Inputs::PREV);
         } else if (drive_controller.circleWasPressed()) {
             recorder_state = servo_recorder->inputEvent(ServoAnimationRecorder::Inputs::NEXT);
+        } else if (aux_controller.l1WasPressed()) {
+            recorder_state = servo_recorder->inputEvent(ServoAnimationRecorder::Inputs::PLAY);
         } else if (aux_controller.upWasReleased()) {
             servo_recorder->addTrackToKeyframe(audio_track_selection_list[0], &dfmp3);
         } else if (aux_controller.rightWasReleased()) {
@@ -836,8 +832,9 @@ void mapInputs(float dt) {
                 sprintf(file_name_buff, ANIMATION_FILE_FORMATTER, save_to_button_index);
                 animation->save(SPIFFS, file_name_buff);
 
-                // Delete the old animation and store the new one
+                // Delete the old animation and store the new one. The motion task must not play or queue it any more.
                 if (head_animations[save_to_button_index] != nullptr) {
+                    servo_player.forget(head_animations[save_to_button_index]);
                     delete head_animations[save_to_button_index];
                 }
                 head_animations[save_to_button_index] = animation;